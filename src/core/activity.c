@@ -0,0 +1,144 @@
+#include "activity.h"
+
+void activity_init(ActivityState* state) {
+    memset(state, 0, sizeof(*state));
+    state->saved.dailyGoal = 8250;
+    state->saved.daysNo = 1;
+    state->saved.daysYes = 1;
+    state->saved.dayNumber = ACTIVITY_NO_DAY;
+    state->lastMinute = UINT32_MAX;
+    stats_init(&state->stats);
+}
+
+uint32_t activity_add_batch(ActivityState* state, uint32_t steps, const BatchStats* stats) {
+    uint32_t events = 0;
+
+    // Detect off-the-wrist condition not to buzz when nobody hears it. Or at night.
+    // Counted in samples, batches are not always the same size.
+    if(stats->lowEnergy){
+        state->sleepCounterPerPeriod += stats->samples;
+    }else{
+        state->otherCounterPerPeriod += stats->samples;
+    }
+
+    if(steps > 0){
+        state->saved.totalSteps += steps;
+        events |= ACTIVITY_STEPS;
+        if(state->saved.totalSteps >= state->saved.dailyGoal && !state->saved.dailyGoalBuzzed){
+            state->saved.dailyGoalBuzzed = true;
+            events |= ACTIVITY_GOAL_REACHED;
+        }
+    }
+    return events;
+}
+
+// The accelerometer was off for part of the minute because nothing moved: counts the
+// samples the minute is short of as quiet ones
+static void fill_quiet(ActivityState* state, uint32_t samplesPerMinute) {
+    uint32_t seen = state->sleepCounterPerPeriod + state->otherCounterPerPeriod;
+    if(seen < samplesPerMinute){
+        state->sleepCounterPerPeriod += samplesPerMinute - seen;
+    }
+}
+
+int activity_day_number(int year, int yday) {
+    // Leap days between 1970 and the start of the year, year is tm_year (1900 based)
+    int y = year + 1900 - 1;
+    return (year - 70)*365 + (y/4 - 1969/4) - (y/100 - 1969/100) + (y/400 - 1969/400) + yday;
+}
+
+MinuteEvent activity_event(const struct tm* tick_time, uint32_t minute, uint16_t samplesPerMinute) {
+    return (MinuteEvent) {
+        .minute = minute,
+        .year = tick_time->tm_year,
+        .yday = tick_time->tm_yday,
+        .samplesPerMinute = samplesPerMinute,
+    };
+}
+
+// Before the day numbers dayNumber was the tm_yday, 0..365. Real day numbers are way above that.
+#define ACTIVITY_LEGACY_DAYS 366
+
+static uint32_t new_day(ActivityState* state, int day) {
+    // Next day, reset all. The goal follows how the last week went, not just yesterday.
+    stats_day_end(&state->stats, state->saved.totalSteps, state->saved.activeMinutes, state->saved.dailyGoal);
+    if(state->saved.totalSteps < state->saved.dailyGoal){
+        state->saved.daysNo++;
+    }else{
+        state->saved.daysYes++;
+    }
+    state->saved.dailyGoal = stats_next_goal(&state->stats, state->saved.dailyGoal);
+
+    state->saved.dayNumber = day;
+    state->saved.totalSteps = 0;
+    state->saved.oldSteps = 0;
+    state->saved.activeMinutes = 0;
+    state->saved.dailyGoalBuzzed = false;
+    return ACTIVITY_NEW_DAY;
+}
+
+ActivityEffects activity_minute(ActivityState* state, const MinuteEvent* ev) {
+    ActivityEffects fx = { 0 };
+    if(ev->minute == state->lastMinute){
+        return fx;
+    }
+    state->lastMinute = ev->minute;
+
+    // No samples while suspended, that time was as quiet as it gets
+    if(ev->suspended){
+        fill_quiet(state, ev->samplesPerMinute);
+    }
+
+    fx.events = ACTIVITY_MINUTE;
+    state->isSleeping = (state->sleepCounterPerPeriod > ACTIVITY_SLEEP_SAMPLES);
+
+    uint32_t stepsPerPeriod = state->saved.totalSteps - state->saved.oldSteps;
+    state->lastMinuteSteps = stepsPerPeriod;
+    state->saved.oldSteps = state->saved.totalSteps;
+    if(stepsPerPeriod > ACTIVITY_MOVING_STEPS){ // count active if you made more than 50 steps per minute
+        state->saved.segmentsInactive -= stepsPerPeriod/4;
+        state->saved.activeMinutes++;
+        state->isMoving = true;
+        if(state->saved.segmentsInactive <= 0){
+            state->saved.segmentsInactive = 0;
+        }
+    }else if(stepsPerPeriod < 30 && !state->isSleeping){ // less than 30 steps - you're inactive
+        state->saved.segmentsInactive++;
+        state->isMoving = false;
+    }else{
+        state->isMoving = false;
+    }
+    stats_minute(&state->stats, stepsPerPeriod < 30 && !state->isSleeping);
+    state->sleepCounterPerPeriod = 0;
+    state->otherCounterPerPeriod = 0;
+
+    if(state->saved.segmentsInactive > 120){
+        state->saved.segmentsInactive = 120; // to reset the timer you need 480 steps max
+    }
+
+    // The minute that just ended. Off the wrist counts as sleep for the reminders, but nobody slept.
+    fx.minute = ev->minute - 1;
+    fx.level = ev->offWrist ? HISTORY_STILL : history_level(stepsPerPeriod, state->isSleeping);
+
+    int day = activity_day_number(ev->year, ev->yday);
+    if(state->saved.dayNumber == ACTIVITY_NO_DAY){
+        state->saved.dayNumber = day;
+    }else if(state->saved.dayNumber >= 0 && state->saved.dayNumber < ACTIVITY_LEGACY_DAYS){
+        // Saved by an older version, the same yday is still today
+        if(state->saved.dayNumber == ev->yday){
+            state->saved.dayNumber = day;
+        }else{
+            fx.events |= new_day(state, day);
+        }
+    }else if(day > state->saved.dayNumber){
+        // Midnight, or the watch was off or the clock set ahead over it: still one day
+        // ends, the days in between have no steps to tell about
+        fx.events |= new_day(state, day);
+    }else if(day < state->saved.dayNumber){
+        // Clock set back, the steps stay with today whatever it is called now
+        state->saved.dayNumber = day;
+        fx.events |= ACTIVITY_CLOCK_BACK;
+    }
+
+    return fx;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+#include "stats.h"
+#include "history.h"
+
+// Minute level bookkeeping that used to be in update_time(): inactivity counter, sleep
+// detection and the daily goal, adjusted from the rolling stats. When to buzz about the
+// inactivity is up to alerts.h. It is driven by the step detector output
+// and the minute tick, and runs in the background worker.
+//
+// activity_minute() is a reducer: it takes the state and a MinuteEvent, changes the state and
+// says in ActivityEffects what the caller has to do about it (save, send, log the history).
+// It never touches the persist storage, the clock or the messages, so the host tools run
+// the very same code over months of made up minutes.
+
+// Quiet samples per minute (out of 600 at 10 Hz) for the minute to count as sleep,
+// it used to be 56 of 60 ten-sample batches
+#define ACTIVITY_SLEEP_SAMPLES 560
+
+// More steps than this in a minute make it an active one
+#define ACTIVITY_MOVING_STEPS 50
+
+// Events returned by activity_add_batch() and activity_minute()
+#define ACTIVITY_STEPS        (1 << 0)  // totalSteps changed
+#define ACTIVITY_GOAL_REACHED (1 << 1)  // daily goal reached just now
+#define ACTIVITY_MINUTE       (1 << 2)  // a new minute was processed
+#define ACTIVITY_NEW_DAY      (1 << 4)  // day rolled over, goal and days counters changed
+#define ACTIVITY_CLOCK_BACK   (1 << 5)  // the date went backwards, took it without a rollover
+
+// dayNumber before the first minute, the first one seen is taken as today
+#define ACTIVITY_NO_DAY (-1)
+
+// What the store checkpoints, copied to and from flash in one piece. Right-sized fields in
+// an order without padding, changing it means a new STORE_VERSION.
+typedef struct {
+    uint32_t totalSteps;
+    uint32_t oldSteps;          // totalSteps at the start of the current minute
+    uint32_t dailyGoal;
+    uint16_t activeMinutes;
+    int16_t segmentsInactive;   // inactive minutes, 0..120
+    int16_t dayNumber;          // local date as days since 1970-01-01, see activity_day_number()
+    uint16_t daysNo;            // lifetime, the windows are in stats
+    uint16_t daysYes;
+    uint8_t dailyGoalBuzzed : 1;
+    uint8_t reserved;
+} ActivityCheckpoint;
+
+typedef struct {
+    ActivityCheckpoint saved;
+    uint32_t lastMinute;        // MinuteEvent.minute processed last
+    uint16_t lastMinuteSteps;   // steps of the minute processed last
+    uint16_t sleepCounterPerPeriod; // quiet samples this minute
+    uint16_t otherCounterPerPeriod; // and all the others
+    bool isMoving : 1;          // the last minute was an active one
+    bool isSleeping : 1;
+    DailyStats stats;
+} ActivityState;
+
+void activity_init(ActivityState* state);
+
+// Adds the detector output of one accelerometer batch
+uint32_t activity_add_batch(ActivityState* state, uint32_t steps, const BatchStats* stats);
+
+// One minute tick as the worker saw it
+typedef struct {
+    uint32_t minute;            // time(NULL)/60. Only the same minute twice is skipped, an hour
+                                // repeated when DST ends still counts.
+    int16_t year;               // tm_year and tm_yday of the local time, for the day rollover
+    int16_t yday;
+    uint16_t samplesPerMinute;  // samples a full minute would have
+    bool suspended;             // the accelerometer was off for part of the minute, nothing moved
+    bool offWrist;              // ...and it was off because the watch was lying somewhere
+} MinuteEvent;
+
+// What the caller has to do after activity_minute()
+typedef struct {
+    uint32_t events;            // ACTIVITY_* flags, 0 when the minute was already processed
+    uint32_t minute;            // the minute that just ended, for the history
+    HistoryLevel level;         // and what it was
+} ActivityEffects;
+
+// Local date to the day number kept in dayNumber. Unlike tm_yday it keeps growing over
+// New Year, and fits in the int16 the store keeps it in until 2059.
+int activity_day_number(int year, int yday);
+
+MinuteEvent activity_event(const struct tm* tick_time, uint32_t minute, uint16_t samplesPerMinute);
+
+// Called on every minute tick, does nothing if the minute was already processed.
+// A date going forward (midnight, or the clock set ahead) rolls the day over once.
+// A date going backwards (clock set back) is taken as today without touching the counters.
+ActivityEffects activity_minute(ActivityState* state, const MinuteEvent* ev);
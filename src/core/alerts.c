@@ -0,0 +1,62 @@
+#include "alerts.h"
+
+void alerts_init(AlertScheduler* alerts) {
+    alerts->due = 0;
+    alerts->last = 0;
+    alerts->level = 0;
+}
+
+static bool is_quiet_hour(int hour) {
+    if(ALERT_QUIET_START > ALERT_QUIET_END){
+        return hour >= ALERT_QUIET_START || hour < ALERT_QUIET_END;
+    }
+    return hour >= ALERT_QUIET_START && hour < ALERT_QUIET_END;
+}
+
+// Moves a time in the quiet hours to their end
+static time_t after_quiet_hours(time_t t) {
+    struct tm* local = localtime(&t);
+    if(!is_quiet_hour(local->tm_hour)){
+        return t;
+    }
+    int hours = (ALERT_QUIET_END - local->tm_hour + 24) % 24;
+    return t + hours*3600 - local->tm_min*60 - local->tm_sec;
+}
+
+time_t alerts_next(AlertScheduler* alerts, const ActivityState* state, time_t now) {
+    if(state->isMoving){
+        alerts->last = 0;
+        alerts->level = 0;
+    }
+    if(state->isSleeping){
+        return 0;
+    }
+
+    time_t due;
+    if(alerts->last){
+        due = alerts->last + ALERT_REPEAT_MINUTES*60;
+    }else{
+        // If nothing happens the counter goes up by one a minute
+        int minutes = ALERT_INACTIVE_MINUTES - state->saved.segmentsInactive;
+        // Walking brings it down, look again next minute instead of going off over and over
+        if(minutes <= 0 && state->isMoving){
+            minutes = 1;
+        }
+        due = now + (minutes > 0 ? minutes*60 : 0);
+    }
+    if(due < now){
+        due = now;
+    }
+    return after_quiet_hours(due);
+}
+
+uint32_t alerts_fire(AlertScheduler* alerts, time_t now) {
+    uint32_t pulse = ALERT_PULSE_FIRST + alerts->level*ALERT_PULSE_STEP;
+    if(pulse > ALERT_PULSE_MAX){
+        pulse = ALERT_PULSE_MAX;
+    }
+    alerts->level++;
+    alerts->last = now;
+    alerts->due = 0;
+    return pulse;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "platform.h"
+#include "activity.h"
+
+// When to remind about moving. The policy is the one update_time() had: the first reminder
+// when the inactivity counter reaches ALERT_INACTIVE_MINUTES, then one every ALERT_REPEAT_MINUTES,
+// each pulse ALERT_PULSE_STEP ms longer, until a minute with real walking in it. None while
+// asleep (or off the wrist), and now none in the quiet hours either.
+// Instead of checking every minute the worker asks for the time the next one is due and sets
+// a timer for it. The answer only changes when the wearer does something unexpected - moves,
+// falls asleep - and then the timer is moved or cancelled.
+
+#define ALERT_INACTIVE_MINUTES 60
+#define ALERT_REPEAT_MINUTES 6
+#define ALERT_PULSE_FIRST 50
+#define ALERT_PULSE_STEP 50
+#define ALERT_PULSE_MAX 550
+
+// Hours without reminders, local time, the end is exclusive
+#define ALERT_QUIET_START 22
+#define ALERT_QUIET_END 7
+
+typedef struct {
+    time_t due;         // what the timer is set for, 0 = no timer
+    time_t last;        // last reminder, 0 = not reminding
+    uint16_t level;     // reminders since the last walk
+} AlertScheduler;
+
+void alerts_init(AlertScheduler* alerts);
+
+// Time of the next reminder from the state after the minute just processed, 0 for none.
+// Ends the reminding when the minute was an active one.
+time_t alerts_next(AlertScheduler* alerts, const ActivityState* state, time_t now);
+
+// The timer went off, returns the pulse length in ms
+uint32_t alerts_fire(AlertScheduler* alerts, time_t now);
@@ -0,0 +1,149 @@
+#include "cadence.h"
+
+#define EV_SHIFT DETECTOR_EV_SHIFT
+#define BASELINE_SHIFT 4        // baseline follows the magnitude with a ~1.6 s time constant
+#define X_MAX 2047              // keeps energy and corr within int32 over the window
+
+// The best lag has to explain this much of the energy, in 1/16
+#define CORR_MIN 8
+// and the window has to move at least this much (RMS, mg), sitting still has a rhythm of noise
+#define RMS_MIN 40
+// One stride (two steps) correlates at least as well as one step, and at 10 Hz a fast step
+// period falls between two lags and correlates worse than the stride. If half the best period
+// correlates more than a quarter as well, the best one was the stride. For a rhythm that is
+// really at the best period half of it is anti-correlated.
+#define HALF_SHARE_SHIFT 2
+// corr[] index of the first lag longer than a step. Those are only searched when no step lag
+// has a rhythm: a smooth gait swings once per stride and has little to show per step, but
+// for a walk two strides can correlate as well as one.
+#define STRIDE_FIRST (CADENCE_LAG_MAX - CADENCE_LAG_MIN + 2)
+// The window remembers the rhythm for a few seconds after it stopped, the batch itself has
+// to move at least this much (max - min, mg) for its steps to count
+#define MOTION_MIN 80
+// Steps count after the gait lasted this long, the peak engine waits for 8 steps in a row
+#define LOCK_SAMPLES 40
+
+void cadence_init(CadenceDetector* det) {
+    memset(det, 0, sizeof(*det));
+    det->baseline = -1;
+}
+
+static inline void add_sample(CadenceDetector* det, uint32_t ev) {
+    if(det->baseline < 0){
+        det->baseline = ev << (7 - EV_SHIFT);
+    }
+    // Baseline in 1/128 mg, the magnitude comes in 1/8 mg
+    det->baseline += ((int32_t) (ev << (7 - EV_SHIFT)) - det->baseline) >> BASELINE_SHIFT;
+    int32_t x = ((int32_t) (ev << (7 - EV_SHIFT)) - det->baseline) >> 7;
+    if(x > X_MAX) x = X_MAX;
+    if(x < -X_MAX) x = -X_MAX;
+
+    // New sample in, the one a window ago out
+    const uint8_t mask = CADENCE_BUFFER - 1;
+    uint8_t t = det->head;
+    uint8_t old = (t - CADENCE_WINDOW) & mask;
+    int32_t xOld = det->x[old];
+    det->x[t] = x;
+    det->energy += x*x - xOld*xOld;
+    for(int i=0;i<CADENCE_LAGS;i++){
+        int lag = CADENCE_LAG_MIN - 1 + i;
+        det->corr[i] += x*det->x[(t - lag) & mask] - xOld*det->x[(old - lag) & mask];
+    }
+    det->head = (t + 1) & mask;
+}
+
+// Index of the best correlated lag in [from, to)
+static inline int best_lag(const int32_t* c, int from, int to) {
+    int best = from;
+    for(int i=from+1;i<to;i++){
+        if(c[i] > c[best]) best = i;
+    }
+    return best;
+}
+
+// Period in 1/16 sample of the rhythm in the window, 0 if there is none
+static uint16_t find_period(const CadenceDetector* det) {
+    const int32_t* c = det->corr;
+    if(det->energy < RMS_MIN*RMS_MIN*CADENCE_WINDOW){
+        return 0;
+    }
+    int32_t corrMin = (det->energy >> 4)*CORR_MIN;
+    bool stride = false;
+    int best = best_lag(c, 1, STRIDE_FIRST);
+    if(c[best] < corrMin){
+        best = best_lag(c, STRIDE_FIRST, CADENCE_LAGS - 1);
+        if(c[best] < corrMin){
+            return 0;
+        }
+        stride = true;
+    }
+
+    // Parabola through the peak and its neighbours for the fraction of a sample.
+    // Scaled down so that 8*(difference) fits.
+    int32_t left = c[best-1] >> 4;
+    int32_t mid = c[best] >> 4;
+    int32_t right = c[best+1] >> 4;
+    int32_t den = left - 2*mid + right;
+    int32_t frac = den < 0 ? 8*(left - right)/den : 0;
+    if(frac > 8) frac = 8;
+    if(frac < -8) frac = -8;
+    uint16_t period = (CADENCE_LAG_MIN - 1 + best)*16 + frac;
+
+    uint16_t half = period/2;
+    if(stride){
+        period = half;
+    }else if(half >= CADENCE_LAG_MIN*16){
+        // Linear between the two lags around it
+        int i = (half >> 4) - (CADENCE_LAG_MIN - 1);
+        int32_t f = half & 15;
+        int32_t atHalf = (c[i] >> 4)*(16 - f) + (c[i+1] >> 4)*f;
+        if(atHalf > c[best] >> HALF_SHARE_SHIFT){
+            period = half;
+        }
+    }
+    return period;
+}
+
+uint32_t cadence_process(CadenceDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) {
+    uint32_t n = size < DETECTOR_BATCH_MAX ? size : DETECTOR_BATCH_MAX;
+    uint32_t ev[DETECTOR_BATCH_MAX];
+    MagnitudeSummary ms;
+
+    stats->samples = n;
+    stats->motion = 0;
+    stats->lowEnergy = false;
+    if(n == 0){
+        return 0;
+    }
+
+    magnitude_batch(data, n, ev, &ms);
+    for(uint32_t i=0;i<n;i++){
+        add_sample(det, ev[i]);
+    }
+
+    stats->motion = (ms.max - ms.min) >> EV_SHIFT;
+    stats->lowEnergy = ms.sum*10 < ((uint32_t) DETECTOR_DEFAULT_PARAMS.sleepEnergy << EV_SHIFT)*n;
+
+    // One decision per batch, the cadence doesn't change faster than that
+    uint16_t period = stats->motion >= MOTION_MIN ? find_period(det) : 0;
+    uint32_t counted = 0;
+    det->period = period;
+    if(period == 0){
+        det->locked = 0;
+        det->pending = 0;
+        det->phase = 0;
+    }else{
+        det->phase += n*16;
+        while(det->phase >= period){
+            det->phase -= period;
+            det->pending++;
+        }
+        det->locked += n;
+        if(det->locked >= LOCK_SAMPLES){
+            counted = det->pending;
+            det->pending = 0;
+            det->locked = LOCK_SAMPLES;
+        }
+    }
+    return counted;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+
+// Step engine that looks for a rhythm instead of peaks. The magnitude, minus its slow moving
+// baseline, goes through a 4 s circular buffer and the autocorrelation of that window is kept
+// up to date sample by sample for lags that cover 1.1..3.3 steps per second, and the strides
+// of those steps. While one lag correlates well enough there is a gait, and steps are counted
+// at that cadence. A smooth motion without impacts (elliptical trainer) still has a rhythm,
+// one per stride from the arm and the hip going round, random bumps in a car don't.
+//
+// Fixed cost: CADENCE_LAGS+1 multiply-adds twice per sample and one lag search per batch,
+// no matter what the signal looks like.
+
+#define CADENCE_WINDOW 40       // samples the correlation is taken over, 4 s at 10 Hz
+#define CADENCE_LAG_MIN 3       // 3.3 steps/s
+#define CADENCE_LAG_MAX 9       // 1.1 steps/s
+#define CADENCE_STRIDE_MAX (2*CADENCE_LAG_MAX)  // a stride, two steps, of the slowest cadence
+#define CADENCE_LAGS (CADENCE_STRIDE_MAX - CADENCE_LAG_MIN + 3)    // one more on each side to interpolate
+#define CADENCE_BUFFER 64       // > CADENCE_WINDOW + CADENCE_STRIDE_MAX + 1, power of 2
+
+typedef struct {
+    int16_t x[CADENCE_BUFFER];  // magnitude minus baseline, mg
+    uint8_t head;               // where the next sample goes
+    int32_t baseline;           // slow average of the magnitude, 1/128 mg
+    int32_t energy;             // sum of x^2 over the window
+    int32_t corr[CADENCE_LAGS]; // sum of x[t]*x[t-lag] over the window, lag = CADENCE_LAG_MIN-1+i
+    uint16_t period;            // cadence in samples per step, 1/16 sample, 0 = no gait
+    uint16_t phase;             // samples since the last step counted, 1/16 sample
+    uint16_t locked;            // samples the gait has lasted
+    uint32_t pending;           // steps waiting for the gait to last long enough
+} CadenceDetector;
+
+void cadence_init(CadenceDetector* det);
+
+// Same contract as detector_process()
+uint32_t cadence_process(CadenceDetector* det, const AccelData* data, uint32_t size, BatchStats* stats);
@@ -0,0 +1,115 @@
+#include "detector_pipeline.h"
+#include "ratio_detector.h"
+
+const DetectorParams DETECTOR_DEFAULT_PARAMS = DETECTOR_DEFAULTS;
+
+void detector_init(StepDetector* det, const DetectorParams* params) {
+    det->params = params ? params : &DETECTOR_DEFAULT_PARAMS;
+    det->lastEv = 0;
+    det->lastStepNo = 0;
+    det->stepsInARow = 0;
+    det->steps = 0;
+}
+
+// The production detector, every threshold folded into the code
+DETECTOR_DEFINE(detector_process, DETECTOR_DEFAULTS)
+
+#ifdef HOST_BUILD
+uint32_t detector_process_params(StepDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) {
+    return detector_pipeline(det, det->params, data, size, stats);
+}
+#endif
+
+#if DETECTOR_FLOAT_REFERENCE
+
+uint32_t detector_process_float(FloatStepDetector* det, const AccelData* data, uint32_t size, bool* lowEnergy) {
+    float evMean = 0;
+    float ev[10];
+    float evAv[10];
+
+    for(uint32_t i=0;i<size&&i<10;i++){
+        ev[i] = my_sqrt(data[i].x*data[i].x + data[i].y*data[i].y + data[i].z*data[i].z);
+    }
+
+    evAv[0] = (det->lastEv + ev[0])/2;
+    evAv[1] = (det->lastEv + ev[0]+ev[1])/3;
+    for(int i=2;i<10;i++){
+        evAv[i] = (ev[i]+ev[i-1]+ev[i-2])/3;
+    }
+    det->lastEv = ev[9];
+
+    for(int i=0;i<10;i++){
+        evMean += ev[i];
+        if(det->lastStepNo > 2 && ev[i] > evAv[i]*1.05 && evAv[i] > 70){
+            det->steps++;
+            if(det->lastStepNo < 9)det->stepsInARow++;
+            else{
+                det->stepsInARow = 0;
+                det->steps = 0;
+            }
+            det->lastStepNo = 0;
+        }
+        det->lastStepNo++;
+    }
+
+    uint32_t counted = 0;
+    if(det->stepsInARow > 7){
+        counted = det->steps;
+        det->steps = 0;
+    }
+
+    *lowEnergy = evMean < 10300;
+    return counted;
+}
+
+#define BENCH_BATCHES 600
+
+static void fill_walk(AccelData* data, int batch) {
+    // Roughly a 2 Hz walk: gravity on z and a swing on x/z
+    static const int16_t swing[5] = {0, 180, 300, 180, 0};
+    for(int i=0;i<10;i++){
+        int k = (batch*10 + i) % 5;
+        data[i].x = 40 + swing[k]/2;
+        data[i].y = -120;
+        data[i].z = -980 + swing[k];
+    }
+}
+
+static uint32_t elapsed_ms(time_t s0, uint16_t ms0) {
+    time_t s1;
+    uint16_t ms1;
+    time_ms(&s1, &ms1);
+    return (uint32_t) (s1 - s0)*1000 + ms1 - ms0;
+}
+
+void detector_benchmark(void) {
+    static AccelData data[10];
+    StepDetector det;
+    FloatStepDetector fdet = {0};
+    uint32_t steps = 0;
+    uint32_t fsteps = 0;
+    bool lowEnergy;
+    BatchStats stats;
+    time_t s0;
+    uint16_t ms0;
+
+    detector_init(&det, NULL);
+    time_ms(&s0, &ms0);
+    for(int b=0;b<BENCH_BATCHES;b++){
+        fill_walk(data, b);
+        steps += detector_process(&det, data, 10, &stats);
+    }
+    uint32_t intMs = elapsed_ms(s0, ms0);
+
+    time_ms(&s0, &ms0);
+    for(int b=0;b<BENCH_BATCHES;b++){
+        fill_walk(data, b);
+        fsteps += detector_process_float(&fdet, data, 10, &lowEnergy);
+    }
+    uint32_t floatMs = elapsed_ms(s0, ms0);
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "detector: int %d us/batch (%d steps), float %d us/batch (%d steps)",
+            (int) (intMs*1000/BENCH_BATCHES), (int) steps, (int) (floatMs*1000/BENCH_BATCHES), (int) fsteps);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "detector.h"
+#include "magnitude.h"
+
+// The peak detector as a chain of stages:
+//   magnitude -> smoothing -> peak detection -> run-length gating -> sleep classification
+// Every stage is a static inline function taking the DetectorParams it needs. A detector is
+// put together with DETECTOR_DEFINE(name, {params}): the parameters become a constant the
+// compiler sees, so the whole chain is inlined into one function and every threshold is
+// folded into the code, the same as if the numbers were typed into it.
+// detector.c defines detector_process() this way with DETECTOR_DEFAULTS, the host tools can
+// define as many others as they want next to it.
+//
+// Thresholds of the float version, rewritten for integers:
+//   ev > evAv*1.05  with evAv = sum/n   <=>   ev*n*20 > sum*21
+//   evAv > 70                           <=>   sum > 70*n
+//   evMean < 10300  (sum of 10 magnitudes, mg)  <=>   sum*10 < 10300*n
+// Magnitudes carry 3 fractional bits (1/8 mg), otherwise rounding every sample to a whole mg
+// shifts the 10-sample sum enough to flip the sleep threshold now and then.
+
+#define EV_SHIFT DETECTOR_EV_SHIFT
+
+#define DETECTOR_INLINE static inline __attribute__((always_inline))
+
+// 1. Magnitude is magnitude_batch() in magnitude.h, it gives the sum, min and max on the way
+
+// 2. Very simple moving average, kept as sums so the division never happens
+DETECTOR_INLINE void stage_smooth(uint32_t lastEv, const uint32_t* ev, uint32_t n, uint32_t* sum, uint32_t* count) {
+    sum[0] = lastEv + ev[0];
+    count[0] = 2;
+    if(n > 1){
+        sum[1] = lastEv + ev[0] + ev[1];
+        count[1] = 3;
+    }
+    for(uint32_t i=2;i<n;i++){
+        sum[i] = ev[i] + ev[i-1] + ev[i-2];
+        count[i] = 3;
+    }
+}
+
+// 3. A peak is above the average line, the average is above the minimum energy and the
+// last peak was long enough ago
+DETECTOR_INLINE bool stage_peak(const DetectorParams* p, int lastStepNo, uint32_t ev, uint32_t sum, uint32_t count) {
+    return lastStepNo > p->minGap
+        && ev*count*p->ratioDen > sum*p->ratioNum
+        && sum > ((uint32_t) p->minAverage << EV_SHIFT)*count;
+}
+
+// 4. Run-length gating: a peak soon enough after the last one continues the sequence,
+// otherwise the sequence and its steps start over
+DETECTOR_INLINE void stage_run_add(StepDetector* det, const DetectorParams* p) {
+    det->steps++;
+    if(det->lastStepNo < p->maxGap){
+        det->stepsInARow++; // last step was less than 0.9 seconds before this one, it's a sequence
+    }else{
+        det->stepsInARow = 0;
+        det->steps = 0;
+    }
+    det->lastStepNo = 0;
+}
+
+// Count steps only if there are several steps in a row to avoid random movements
+DETECTOR_INLINE uint32_t stage_run_commit(StepDetector* det, const DetectorParams* p) {
+    uint32_t counted = 0;
+    if(det->stepsInARow > p->minRun){
+        counted = det->steps;
+        det->steps = 0;
+    }
+    return counted;
+}
+
+// 5. Sleep classification of the whole batch from the sum of its magnitudes
+DETECTOR_INLINE bool stage_sleep(const DetectorParams* p, uint32_t evSum, uint32_t n) {
+    return evSum*10 < ((uint32_t) p->sleepEnergy << EV_SHIFT)*n;
+}
+
+DETECTOR_INLINE uint32_t detector_pipeline(StepDetector* det, const DetectorParams* p,
+                                           const AccelData* data, uint32_t size, BatchStats* stats) {
+    uint32_t ev[DETECTOR_BATCH_MAX];
+    uint32_t sum[DETECTOR_BATCH_MAX];
+    uint32_t count[DETECTOR_BATCH_MAX];
+    MagnitudeSummary ms;
+    uint32_t n = size < DETECTOR_BATCH_MAX ? size : DETECTOR_BATCH_MAX;
+
+    stats->samples = n;
+    stats->motion = 0;
+    stats->lowEnergy = false;
+    if(n == 0){
+        return 0;
+    }
+
+    magnitude_batch(data, n, ev, &ms);
+
+    stage_smooth(det->lastEv, ev, n, sum, count);
+    det->lastEv = ev[n-1];
+
+    for(uint32_t i=0;i<n;i++){
+        if(stage_peak(p, det->lastStepNo, ev[i], sum[i], count[i])){
+            stage_run_add(det, p);
+        }
+        det->lastStepNo++;
+    }
+    uint32_t counted = stage_run_commit(det, p);
+
+    stats->motion = (ms.max - ms.min) >> EV_SHIFT;
+    stats->lowEnergy = stage_sleep(p, ms.sum, n);
+    return counted;
+}
+
+// Defines `uint32_t name(StepDetector*, const AccelData*, uint32_t, BatchStats*)` running
+// the pipeline with the given DetectorParams initializer, for example
+//   DETECTOR_DEFINE(detector_process_strict, { .ratioNum = 11, .ratioDen = 10, ... })
+// det->params is not used by it.
+#define DETECTOR_DEFINE(name, ...) \
+    uint32_t name(StepDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) { \
+        static const DetectorParams params = __VA_ARGS__; \
+        return detector_pipeline(det, &params, data, size, stats); \
+    }
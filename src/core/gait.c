@@ -0,0 +1,166 @@
+#include "gait.h"
+
+#define EV_SHIFT DETECTOR_EV_SHIFT
+#define GRAVITY_SHIFT 4         // ~1.6 s time constant, slower than any gait
+#define VAR_SHIFT 3             // ~0.8 s
+#define D_MAX 2047              // keeps the squares and the variance within int32
+
+// Decision tree thresholds, variances summed over the axes in mg^2
+#define STILL_VAR (40*40)       // under 40 mg RMS nothing is going on
+#define RUN_VAR (350*350)       // running moves more than that...
+#define RUN_PERIOD (42*16/10)   // ...with steps shorter than this, 1/16 sample (2.4 steps/s)
+
+// Cycle lengths in samples at 10 Hz: steps of 1..3.5 per second, strides twice that
+#define STEP_MIN 2
+#define STEP_MAX 10
+#define STRIDE_MIN 5
+#define STRIDE_MAX 20
+
+// Follow another axis only when it moves this much more, in 1/4
+#define SWITCH_MARGIN 5
+
+void gait_init(GaitDetector* det) {
+    memset(det, 0, sizeof(*det));
+    det->gravity[0] = INT32_MIN;
+}
+
+static inline int vertical_axis(const GaitDetector* det) {
+    int32_t best = 0;
+    int axis = 0;
+    for(int i=0;i<3;i++){
+        int32_t g = det->gravity[i] < 0 ? -det->gravity[i] : det->gravity[i];
+        if(g > best){
+            best = g;
+            axis = i;
+        }
+    }
+    return axis;
+}
+
+static void lose_rhythm(GaitDetector* det) {
+    det->cycles = 0;
+    det->pending = 0;
+}
+
+// One more cycle of the followed axis, steps go to pending until the rhythm is regular
+static inline void add_cycle(GaitDetector* det, uint16_t period, bool vertical) {
+    uint8_t lo = vertical ? STEP_MIN : STRIDE_MIN;
+    uint8_t hi = vertical ? STEP_MAX : STRIDE_MAX;
+    if(period < lo || period > hi){
+        lose_rhythm(det);
+        return;
+    }
+    det->periods[det->head] = period;
+    det->head = (det->head + 1) % GAIT_CYCLES;
+    if(det->cycles < GAIT_CYCLES){
+        det->cycles++;
+    }
+    det->pending += vertical ? 1 : 2;
+}
+
+static inline void add_sample(GaitDetector* det, const AccelData* a, int32_t hysteresis, bool vertical) {
+    int32_t v[3] = { a->x, a->y, a->z };
+    int32_t d[3];
+    for(int i=0;i<3;i++){
+        det->gravity[i] += ((v[i] << 4) - det->gravity[i]) >> GRAVITY_SHIFT;
+        d[i] = v[i] - (det->gravity[i] >> 4);
+        if(d[i] > D_MAX) d[i] = D_MAX;
+        if(d[i] < -D_MAX) d[i] = -D_MAX;
+        det->var[i] += (d[i]*d[i] - det->var[i]) >> VAR_SHIFT;
+    }
+
+    int32_t x = d[det->axis];
+    if(det->sinceUp < UINT16_MAX){
+        det->sinceUp++;
+    }
+    if(!det->above && x > hysteresis){
+        det->above = true;
+        add_cycle(det, det->sinceUp, vertical);
+        det->sinceUp = 0;
+    }else if(det->above && x < -hysteresis){
+        det->above = false;
+    }
+}
+
+static GaitState classify(const GaitDetector* det, int32_t energy, bool vertical) {
+    if(energy < STILL_VAR){
+        return GAIT_STATIONARY;
+    }
+    if(det->cycles < GAIT_CYCLES){
+        return GAIT_VEHICLE;
+    }
+    uint8_t lo = UINT8_MAX;
+    uint8_t hi = 0;
+    uint16_t sum = 0;
+    for(int i=0;i<GAIT_CYCLES;i++){
+        uint8_t p = det->periods[i];
+        lo = p < lo ? p : lo;
+        hi = p > hi ? p : hi;
+        sum += p;
+    }
+    // A sample either way is the resolution at 10 Hz
+    if(hi - lo > (hi >> 2) + 1){
+        return GAIT_VEHICLE;
+    }
+    uint16_t step = sum*16/GAIT_CYCLES / (vertical ? 1 : 2);
+    return energy > RUN_VAR && step < RUN_PERIOD ? GAIT_RUNNING : GAIT_WALKING;
+}
+
+uint32_t gait_process(GaitDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) {
+    uint32_t n = size < DETECTOR_BATCH_MAX ? size : DETECTOR_BATCH_MAX;
+    uint32_t ev[DETECTOR_BATCH_MAX];
+    MagnitudeSummary ms;
+
+    stats->samples = n;
+    stats->motion = 0;
+    stats->lowEnergy = false;
+    if(n == 0){
+        return 0;
+    }
+    if(det->gravity[0] == INT32_MIN){
+        det->gravity[0] = data[0].x << 4;
+        det->gravity[1] = data[0].y << 4;
+        det->gravity[2] = data[0].z << 4;
+    }
+
+    // The magnitude is still what sleep and the sampling rate go by
+    magnitude_batch(data, n, ev, &ms);
+    stats->motion = (ms.max - ms.min) >> EV_SHIFT;
+    stats->lowEnergy = ms.sum*10 < ((uint32_t) DETECTOR_DEFAULT_PARAMS.sleepEnergy << EV_SHIFT)*n;
+
+    // Half the RMS of the followed axis, noise doesn't cross that both ways
+    int32_t hysteresis = magnitude_isqrt(det->var[det->axis]) >> 1;
+    bool vertical = det->axis == vertical_axis(det);
+    for(uint32_t i=0;i<n;i++){
+        add_sample(det, &data[i], hysteresis, vertical);
+    }
+
+    int best = det->axis;
+    for(int i=0;i<3;i++){
+        if(det->var[i]*4 > det->var[best]*SWITCH_MARGIN){
+            best = i;
+        }
+    }
+    if(best != det->axis){
+        det->axis = best;
+        det->above = false;
+        lose_rhythm(det);
+    }
+    if(det->sinceUp > STRIDE_MAX){
+        // Stopped
+        lose_rhythm(det);
+    }
+
+    int32_t energy = det->var[0] + det->var[1] + det->var[2];
+    det->state = classify(det, energy, vertical);
+    if(det->state == GAIT_WALKING || det->state == GAIT_RUNNING){
+        uint32_t counted = det->pending;
+        det->pending = 0;
+        return counted;
+    }
+    if(det->state != GAIT_VEHICLE || det->cycles == GAIT_CYCLES){
+        // Not a gait for sure, whatever was pending wasn't steps
+        det->pending = 0;
+    }
+    return 0;
+}
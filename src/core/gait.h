@@ -0,0 +1,46 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+
+// Step engine that looks at the three axes instead of the magnitude. The magnitude hardly moves
+// when the arm swings in the horizontal plane (elliptical trainer, hands on the handles), and
+// a car's bumps look like steps to it. Here every axis keeps a gravity estimate (slow low-pass)
+// and the variance of what is left, the axis that moves most is followed and its cycles are
+// timed between zero crossings with hysteresis. A small decision tree on the variance, the
+// cycle lengths and how regular they are says what the wearer is doing, and steps are counted
+// only while that is a gait.
+//
+// A cycle on the axis gravity is on is one step (the body bounces every step), on any other
+// axis it is a stride, two steps (the arm swings once per stride).
+//
+// Per sample: three low-pass filters, three squares and a compare, ~40 bytes of state.
+
+typedef enum {
+    GAIT_STATIONARY,
+    GAIT_VEHICLE,           // moving, but not in a rhythm a gait has: a car, a bus, fidgeting
+    GAIT_WALKING,
+    GAIT_RUNNING,
+} GaitState;
+
+// Regular cycles before the steps count, the ones before them are counted then. A rough road
+// lines up four jolts evenly enough every now and then, six it doesn't.
+#define GAIT_CYCLES 6
+
+typedef struct {
+    int32_t gravity[3];     // low-pass of each axis, 1/16 mg
+    int32_t var[3];         // variance of each axis around it, mg^2
+    uint8_t axis;           // the one being followed
+    bool above;             // it is past +hysteresis, waiting for it to go below -hysteresis
+    uint16_t sinceUp;       // samples since the last upward crossing
+    uint8_t periods[GAIT_CYCLES];   // the last cycle lengths, samples
+    uint8_t cycles;         // how many of them are valid, 0..GAIT_CYCLES
+    uint8_t head;
+    uint16_t pending;       // steps of cycles not known to be a gait yet
+    GaitState state;
+} GaitDetector;
+
+void gait_init(GaitDetector* det);
+
+// Same contract as detector_process()
+uint32_t gait_process(GaitDetector* det, const AccelData* data, uint32_t size, BatchStats* stats);
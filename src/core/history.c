@@ -0,0 +1,130 @@
+#include "history.h"
+
+static inline uint32_t chunk_of(uint32_t index) {
+    return (index % HISTORY_MINUTES) / HISTORY_MINUTES_PER_CHUNK;
+}
+
+static inline int get_level(const uint8_t* chunk, uint32_t index) {
+    uint32_t pos = index % HISTORY_MINUTES_PER_CHUNK;
+    return (chunk[pos >> 2] >> ((pos & 3)*2)) & 3;
+}
+
+static inline void set_level(uint8_t* chunk, uint32_t index, int level) {
+    uint32_t pos = index % HISTORY_MINUTES_PER_CHUNK;
+    int shift = (pos & 3)*2;
+    chunk[pos >> 2] = (chunk[pos >> 2] & ~(3 << shift)) | (level << shift);
+}
+
+static void read_chunk(uint32_t chunk, uint8_t* data) {
+    if(persist_read_data(HISTORY_KEY_CHUNK + chunk, data, HISTORY_CHUNK_BYTES) != HISTORY_CHUNK_BYTES){
+        memset(data, 0, HISTORY_CHUNK_BYTES);
+    }
+}
+
+static void read_meta(HistoryMeta* meta) {
+    if(persist_read_data(HISTORY_KEY_META, meta, sizeof(*meta)) != sizeof(*meta)){
+        meta->head = 0;
+        meta->headTime = 0;
+    }
+}
+
+HistoryLevel history_level(uint32_t steps, bool isSleeping) {
+    if(isSleeping){
+        return HISTORY_ASLEEP;
+    }
+    if(steps > 50){
+        return HISTORY_ACTIVE;
+    }
+    return steps >= 10 ? HISTORY_LIGHT : HISTORY_STILL;
+}
+
+void history_load(History* history) {
+    read_meta(&history->meta);
+    read_chunk(chunk_of(history->meta.head), history->chunk);
+    history->dirtyMinutes = 0;
+}
+
+void history_flush(History* history) {
+    if(history->dirtyMinutes == 0){
+        return;
+    }
+    // The chunk head points into, unless head just moved to a fresh one
+    uint32_t last = history->meta.head - 1;
+    persist_write_data(HISTORY_KEY_CHUNK + chunk_of(last), history->chunk, HISTORY_CHUNK_BYTES);
+    persist_write_data(HISTORY_KEY_META, &history->meta, sizeof(history->meta));
+    history->dirtyMinutes = 0;
+}
+
+static void append(History* history, int level) {
+    HistoryMeta* meta = &history->meta;
+    set_level(history->chunk, meta->head, level);
+    meta->head++;
+    meta->headTime++;
+    history->dirtyMinutes++;
+
+    if(meta->head % HISTORY_MINUTES_PER_CHUNK == 0){
+        // Chunk is full, write it and start over the one from a week ago
+        history_flush(history);
+        memset(history->chunk, 0, HISTORY_CHUNK_BYTES);
+    }
+}
+
+void history_add(History* history, uint32_t minute, HistoryLevel level) {
+    HistoryMeta* meta = &history->meta;
+
+    if(meta->head == 0 || minute < meta->headTime){
+        // First record ever, or the clock went back: just continue from here
+        meta->headTime = minute;
+    }else if(minute > meta->headTime){
+        // The worker wasn't running, nothing is known about these minutes
+        uint32_t gap = minute - meta->headTime;
+        if(gap > HISTORY_MINUTES){
+            meta->head += gap - HISTORY_MINUTES;
+            meta->head -= meta->head % HISTORY_MINUTES_PER_CHUNK;
+            meta->headTime = minute - HISTORY_MINUTES;
+            memset(history->chunk, 0, HISTORY_CHUNK_BYTES);
+            gap = HISTORY_MINUTES;
+        }
+        while(gap-- > 0){
+            append(history, HISTORY_STILL);
+        }
+    }
+    append(history, level);
+
+    if(history->dirtyMinutes >= HISTORY_FLUSH_MINUTES){
+        history_flush(history);
+    }
+}
+
+void history_reader_open(HistoryReader* reader, const History* live) {
+    reader->live = live;
+    if(live){
+        reader->meta = live->meta;
+    }else{
+        read_meta(&reader->meta);
+    }
+    reader->cachedChunk = -1;
+}
+
+int history_reader_get(HistoryReader* reader, uint32_t minute) {
+    const HistoryMeta* meta = &reader->meta;
+    if(minute >= meta->headTime){
+        return -1;
+    }
+    uint32_t age = meta->headTime - minute;
+    if(age > meta->head || age > HISTORY_MINUTES - HISTORY_MINUTES_PER_CHUNK){
+        // Older than the history, or in the chunk that is being overwritten
+        return -1;
+    }
+    uint32_t index = meta->head - age;
+    uint32_t chunk = chunk_of(index);
+
+    if(reader->live && chunk == chunk_of(meta->head)){
+        return get_level(reader->live->chunk, index);
+    }
+    if(reader->cachedChunk != (int16_t) chunk){
+        read_chunk(chunk, reader->chunk);
+        reader->cachedChunk = chunk;
+    }
+    return get_level(reader->chunk, index);
+}
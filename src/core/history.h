@@ -0,0 +1,67 @@
+#pragma once
+
+#include "platform.h"
+
+// Per-minute activity history, a ring of 2-bit records covering a bit over 7 days.
+// Persistent storage is 4 KB per app, so a minute can't have more than a couple of bits:
+// 11 chunks of 256 bytes, 1024 minutes each, in 2.75 KB. The oldest chunk is the one being
+// overwritten next and doesn't read, so 10 chunks, 10240 minutes = 7.1 days, can be read back.
+// The chunk being filled is kept in RAM and written behind, once an hour or when it's full.
+
+#define HISTORY_CHUNK_BYTES 256
+#define HISTORY_CHUNKS 11
+#define HISTORY_MINUTES_PER_CHUNK (HISTORY_CHUNK_BYTES*4)
+#define HISTORY_MINUTES (HISTORY_CHUNKS*HISTORY_MINUTES_PER_CHUNK)
+
+// Minutes kept in RAM before they are written out
+#define HISTORY_FLUSH_MINUTES 60
+
+// Persist keys: the metadata and the chunks right after it
+#define HISTORY_KEY_META 99
+#define HISTORY_KEY_CHUNK 100
+
+// What a minute was, steps bucketed the same way update_time() looks at them.
+// Zero is "still" so minutes with no data read as nothing happening.
+typedef enum {
+    HISTORY_STILL = 0,      // under 10 steps
+    HISTORY_LIGHT = 1,      // 10..50 steps
+    HISTORY_ACTIVE = 2,     // more than 50 steps, an active minute
+    HISTORY_ASLEEP = 3,
+} HistoryLevel;
+
+typedef struct {
+    uint32_t head;          // minutes ever written, the next one goes to head % HISTORY_MINUTES
+    uint32_t headTime;      // wall clock minute (time/60) of the next record
+} HistoryMeta;
+
+typedef struct {
+    HistoryMeta meta;
+    uint16_t dirtyMinutes;  // added since the last flush
+    uint8_t chunk[HISTORY_CHUNK_BYTES];     // the chunk head is in
+} History;
+
+HistoryLevel history_level(uint32_t steps, bool isSleeping);
+
+// Loads the metadata and the current chunk
+void history_load(History* history);
+
+// Records the minute that started at wall clock minute `minute` (time/60). Minutes skipped
+// since the last record are filled as still. Flushes when it's time to.
+void history_add(History* history, uint32_t minute, HistoryLevel level);
+
+// Writes the current chunk and the metadata out
+void history_flush(History* history);
+
+// Random access for reading days back. One chunk is cached, so walking minutes in order
+// costs one persist read per 1024 of them.
+typedef struct {
+    const History* live;    // the worker's own history or NULL to read what is persisted
+    HistoryMeta meta;
+    int16_t cachedChunk;
+    uint8_t chunk[HISTORY_CHUNK_BYTES];
+} HistoryReader;
+
+void history_reader_open(HistoryReader* reader, const History* live);
+
+// Level of the given wall clock minute, -1 if it is not in the history
+int history_reader_get(HistoryReader* reader, uint32_t minute);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "platform.h"
+
+// Magnitude of the acceleration, the first thing every batch goes through.
+// Integer square root rounded to the nearest integer, started from a table estimate of the
+// top bits instead of bit by bit: the leading zero count gives the exponent, a 192 byte table
+// gives sqrt of the top 8 bits, two Newton steps make it exact and the last lines round it.
+// About 40 instructions and 2 divisions, where the bit by bit one loops 16 times with a branch
+// in every round. Same results for every input, tools/bench.c checks all of them.
+
+// Magnitudes carry 3 fractional bits (1/8 mg), see detector_pipeline.h
+#define MAGNITUDE_SHIFT 3
+// Largest squared magnitude that still fits after the shift, ~8 g, well above the +-4 g sensor range
+#define MAGNITUDE_MAG2_MAX (UINT32_MAX >> (2*MAGNITUDE_SHIFT))
+
+// sqrt(m)*16 for m = 64..255
+extern const uint8_t MAGNITUDE_SQRT_TABLE[192];
+
+typedef struct {
+    uint32_t sum;
+    uint32_t min;
+    uint32_t max;
+} MagnitudeSummary;
+
+static inline uint32_t magnitude_isqrt(uint32_t num) {
+    if(num == 0){
+        return 0;
+    }
+    // num = m * 4^e with m in 64..255
+    int bits = 32 - __builtin_clz(num);
+    int e = (bits - 7) >> 1;
+    uint32_t m = e >= 0 ? num >> (2*e) : num << (-2*e);
+    uint32_t root = e >= 0 ? ((uint32_t) MAGNITUDE_SQRT_TABLE[m - 64] << e) >> 4
+                           : (uint32_t) MAGNITUDE_SQRT_TABLE[m - 64] >> (4 - e);
+    root += 1;  // never 0 for the division
+
+    root = (root + num/root) >> 1;
+    root = (root + num/root) >> 1;
+
+    // Now within 1 of floor(sqrt), the products can take 33 bits
+    uint64_t r = root;
+    r -= r*r > num;
+    r += (r + 1)*(r + 1) <= num;
+    // sqrt >= r + 0.5 exactly when num > r^2 + r
+    r += num - r*r > r;
+    return (uint32_t) r;
+}
+
+static inline uint32_t magnitude_of(const AccelData* a) {
+    int32_t x = a->x;
+    int32_t y = a->y;
+    int32_t z = a->z;
+    uint32_t mag2 = (uint32_t) (x*x + y*y + z*z);
+    mag2 = mag2 > MAGNITUDE_MAG2_MAX ? MAGNITUDE_MAG2_MAX : mag2;
+    return magnitude_isqrt(mag2 << (2*MAGNITUDE_SHIFT));
+}
+
+// Magnitudes of the whole batch into ev, with their sum, min and max. Two samples per round,
+// min and max are selects, not branches.
+static inline void magnitude_batch(const AccelData* data, uint32_t n, uint32_t* ev, MagnitudeSummary* out) {
+    uint32_t sum = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint32_t i = 0;
+    for(;i+1<n;i+=2){
+        uint32_t a = magnitude_of(&data[i]);
+        uint32_t b = magnitude_of(&data[i+1]);
+        ev[i] = a;
+        ev[i+1] = b;
+        sum += a + b;
+        uint32_t lo = a < b ? a : b;
+        uint32_t hi = a < b ? b : a;
+        min = lo < min ? lo : min;
+        max = hi > max ? hi : max;
+    }
+    if(i < n){
+        uint32_t a = magnitude_of(&data[i]);
+        ev[i] = a;
+        sum += a;
+        min = a < min ? a : min;
+        max = a > max ? a : max;
+    }
+    out->sum = sum;
+    out->min = min;
+    out->max = max;
+}
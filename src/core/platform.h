@@ -0,0 +1,53 @@
+#pragma once
+
+// Everything in core/ builds both for the watch and natively on the host (see tools/).
+// HOST_BUILD replaces pebble.h with the handful of definitions the core code needs,
+// PEBBLE_WORKER (set by the wscript for worker_src) switches to the worker API.
+
+#ifdef HOST_BUILD
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    bool did_vibrate;
+    uint64_t timestamp;
+} AccelData;
+
+#define APP_LOG_LEVEL_ERROR 1
+#define APP_LOG_LEVEL_WARNING 50
+#define APP_LOG_LEVEL_INFO 100
+#define APP_LOG_LEVEL_DEBUG 200
+#define APP_LOG(level, fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+
+static inline uint16_t time_ms(time_t* tloc, uint16_t* ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *tloc = ts.tv_sec;
+    *ms = (uint16_t) (ts.tv_nsec / 1000000);
+    return *ms;
+}
+
+// Persistent storage, tools/host_persist.c keeps it in memory
+bool persist_exists(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_delete(const uint32_t key);
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void* data, const size_t size);
+
+#elif defined(PEBBLE_WORKER)
+
+#include <pebble_worker.h>
+
+#else
+
+#include <pebble.h>
+
+#endif
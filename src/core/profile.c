@@ -0,0 +1,98 @@
+#include "profile.h"
+
+#if PROFILE
+
+static const char* const s_names[PROFILE_PROBES] = {
+    "accel", "detector", "minute", "new day", "render", "draw",
+};
+
+static ProfileStats s_stats[PROFILE_PROBES];
+
+static struct {
+    uint8_t probe;
+    uint32_t ticks;
+} s_ring[PROFILE_RING];
+static uint8_t s_ring_head = 0;
+static uint8_t s_ring_count = 0;
+
+uint32_t profile_clock(void) {
+#ifdef HOST_BUILD
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec*1000000000ULL + ts.tv_nsec);
+#else
+    time_t s;
+    uint16_t ms;
+    time_ms(&s, &ms);
+    return (uint32_t) s*1000 + ms;
+#endif
+}
+
+static int bucket_of(uint32_t ticks) {
+    int b = 0;
+    while(ticks && b < PROFILE_BUCKETS - 1){
+        ticks >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void profile_record(ProfileProbe probe, uint32_t ticks) {
+    ProfileStats* s = &s_stats[probe];
+    if(s->count == 0 || ticks < s->min) s->min = ticks;
+    if(ticks > s->max) s->max = ticks;
+    s->count++;
+    s->total += ticks;
+    uint16_t* bucket = &s->buckets[bucket_of(ticks)];
+    if(*bucket < UINT16_MAX){
+        (*bucket)++;
+    }
+
+    s_ring[s_ring_head].probe = probe;
+    s_ring[s_ring_head].ticks = ticks;
+    s_ring_head = (s_ring_head + 1) % PROFILE_RING;
+    if(s_ring_count < PROFILE_RING){
+        s_ring_count++;
+    }
+}
+
+const ProfileStats* profile_stats(ProfileProbe probe) {
+    return &s_stats[probe];
+}
+
+uint32_t profile_percentile(ProfileProbe probe, int percent) {
+    const ProfileStats* s = &s_stats[probe];
+    uint32_t wanted = (s->count*percent + 99)/100;
+    uint32_t seen = 0;
+    for(int b=0;b<PROFILE_BUCKETS;b++){
+        seen += s->buckets[b];
+        if(seen >= wanted){
+            uint32_t upper = b == 0 ? 0 : (1UL << b) - 1;
+            return upper < s->max ? upper : s->max;
+        }
+    }
+    return s->max;
+}
+
+void profile_dump(void) {
+    for(int p=0;p<PROFILE_PROBES;p++){
+        const ProfileStats* s = &s_stats[p];
+        if(s->count == 0){
+            continue;
+        }
+        APP_LOG(APP_LOG_LEVEL_INFO, "%s: %d calls, avg %d " PROFILE_AVG_UNIT ", min %d max %d, p50 <=%d p90 <=%d p99 <=%d " PROFILE_UNIT,
+                s_names[p], (int) s->count, (int) ((uint64_t) s->total*PROFILE_AVG_SCALE/s->count), (int) s->min, (int) s->max,
+                (int) profile_percentile(p, 50), (int) profile_percentile(p, 90), (int) profile_percentile(p, 99));
+    }
+    // Last few calls, oldest first
+    int last = s_ring_count < 8 ? s_ring_count : 8;
+    for(int i=last;i>0;i--){
+        int k = (s_ring_head + PROFILE_RING - i) % PROFILE_RING;
+        APP_LOG(APP_LOG_LEVEL_INFO, "  %s %d " PROFILE_UNIT, s_names[s_ring[k].probe], (int) s_ring[k].ticks);
+    }
+    memset(s_stats, 0, sizeof(s_stats));
+    s_ring_head = 0;
+    s_ring_count = 0;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "platform.h"
+
+// Profiling of the hot paths, compiled out unless PROFILE is 1 (add it to the defines in the
+// wscript, or -DPROFILE=1 on the host). Every probe keeps a call count, min/max/total and a
+// log2 histogram of durations for the percentiles, and the last PROFILE_RING calls of all
+// probes go into one ring. profile_dump() logs it all and starts over.
+//
+//   PROFILE_BEGIN(t);
+//   ...
+//   PROFILE_END(t, PROFILE_ACCEL);
+//
+// Durations are in ticks of profile_clock(): milliseconds on the watch, nanoseconds on the host.
+// The SDK has nothing finer that an app may read, and the DWT cycle counter faults outside
+// privileged mode. Most single calls on the watch are under a tick, so min, max, the
+// percentiles and the ring mostly read 0 or 1 there and only show the outliers. A call starts
+// at a random point of its millisecond though, so the ticks summed over many calls are an
+// unbiased count of the time spent, and the average is worked out from that total in
+// microseconds (PROFILE_AVG_UNIT).
+
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+typedef enum {
+    PROFILE_ACCEL,          // whole accelerometer handler
+    PROFILE_DETECTOR,       // just the step engine
+    PROFILE_MINUTE,         // minute tick
+    PROFILE_NEW_DAY,        // minute tick that rolled the day over
+    PROFILE_RENDER,         // face render()
+    PROFILE_DRAW,           // face layer update procs, the gauge and the goal bar
+    PROFILE_PROBES
+} ProfileProbe;
+
+#define PROFILE_BUCKETS 16  // bucket b holds durations with b significant bits, the last one the rest
+#define PROFILE_RING 32
+
+typedef struct {
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+    uint16_t buckets[PROFILE_BUCKETS];
+} ProfileStats;
+
+#if PROFILE
+
+#ifdef HOST_BUILD
+#define PROFILE_UNIT "ns"
+#define PROFILE_AVG_UNIT "ns"
+#define PROFILE_AVG_SCALE 1
+#else
+#define PROFILE_UNIT "ms"
+#define PROFILE_AVG_UNIT "us"
+#define PROFILE_AVG_SCALE 1000
+#endif
+
+#define PROFILE_BEGIN(name) uint32_t name = profile_clock()
+#define PROFILE_END(name, probe) profile_record(probe, profile_clock() - name)
+
+uint32_t profile_clock(void);
+void profile_record(ProfileProbe probe, uint32_t ticks);
+const ProfileStats* profile_stats(ProfileProbe probe);
+
+// Upper bound of the histogram bucket the given percentile falls into
+uint32_t profile_percentile(ProfileProbe probe, int percent);
+
+void profile_dump(void);
+
+#else
+
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name, probe)
+#define profile_dump()
+
+#endif
@@ -0,0 +1,78 @@
+#include "ratio_detector.h"
+
+float my_sqrt(const float num) {
+    const uint32_t MAX_STEPS = 30;
+    const float MAX_ERROR = 1.0;
+
+    float answer = num;
+    float ans_sqr = answer * answer;
+    uint32_t step = 0;
+    while((ans_sqr - num > MAX_ERROR) && (step++ < MAX_STEPS)) {
+        if(answer != 0){
+            answer = (answer + (num / answer)) / 2;
+        }
+        ans_sqr = answer * answer;
+    }
+    return answer;
+}
+
+void ratio_detector_init(RatioDetector* det) {
+    det->steps = 0;
+}
+
+uint32_t ratio_detector_process(RatioDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) {
+    float evMax = 0;
+    float evMin = 5000000;
+    float evMean = 0;
+    float ev[DETECTOR_BATCH_MAX];
+
+    // Any batch size the sampling picks, 10 at the start and 25 when idle
+    uint32_t n = size < DETECTOR_BATCH_MAX ? size : DETECTOR_BATCH_MAX;
+    stats->samples = n;
+    if(n == 0){
+        stats->motion = 0;
+        stats->lowEnergy = false;
+        return 0;
+    }
+
+    for(uint32_t i=0;i<n;i++){
+        ev[i] = my_sqrt(data[i].x*data[i].x + data[i].y*data[i].y + data[i].z*data[i].z);
+        ev[i] *= ev[i]; // make peaks sharper
+        if(ev[i] > evMax) evMax = ev[i];
+        if(ev[i] < evMin) evMin = ev[i];
+        evMean += ev[i];
+    }
+    stats->motion = my_sqrt(evMax) - my_sqrt(evMin);
+
+    evMean /= n;
+    evMean -= evMin;
+    evMax -= evMin;
+
+    // filter out too frequent peaks, anyway, only 3 steps per second seem sane
+    // the filter is a bit rough, but who cares!
+    for(uint32_t i=0;i+1<n;i++){
+        if(ev[i+1] == 0)continue;
+        float t = ev[i]/ev[i+1];
+        if(t<1.2 && t>=1){
+            ev[i+1] = evMin;
+        }else if(t<1 && t>0.8){
+            ev[i] = evMin;
+        }
+    }
+
+    for(uint32_t i=0;i<n;i++){
+        // well, I should subtract evMin here, but it works better without!
+        if(ev[i] > evMean+(evMax-evMean)*0.5 && evMean > 575000){
+            det->steps++;
+        }
+    }
+
+    uint32_t counted = det->steps == 1 ? 1 : det->steps/2;
+    det->steps = 0;
+
+    // Normalized squared:
+    // Sleeping: Mean < 30.000
+    // Walking: mean ~600.000
+    stats->lowEnergy = evMean < 20000;
+    return counted;
+}
@@ -0,0 +1,62 @@
+#include "sampling.h"
+
+#define SAMPLE_RATE 10
+
+void sampling_init(SamplingScheduler* sched) {
+    sched->batchSize = SAMPLING_ACTIVE_BATCH;
+    sched->quietSamples = 0;
+    sched->stillSamples = 0;
+    sched->sleepSamples = 0;
+    sched->state = SAMPLING_STREAMING;
+}
+
+static inline void count(uint16_t* counter, uint16_t samples) {
+    if(*counter < UINT16_MAX - samples){
+        *counter += samples;
+    }
+}
+
+uint16_t sampling_update(SamplingScheduler* sched, uint32_t steps, const BatchStats* stats, bool isSleeping) {
+    uint16_t wanted;
+
+    if(steps > 0 || stats->motion >= SAMPLING_QUIET_MOTION){
+        sched->quietSamples = 0;
+        sched->stillSamples = 0;
+        sched->sleepSamples = 0;
+        wanted = SAMPLING_ACTIVE_BATCH;
+    }else{
+        count(&sched->quietSamples, stats->samples);
+        if(stats->motion < SAMPLING_OFF_WRIST_MOTION){
+            count(&sched->stillSamples, stats->samples);
+        }else{
+            sched->stillSamples = 0;
+        }
+        if(isSleeping){
+            count(&sched->sleepSamples, stats->samples);
+        }else{
+            sched->sleepSamples = 0;
+        }
+
+        if(sched->stillSamples >= SAMPLING_OFF_WRIST_SECONDS*SAMPLE_RATE){
+            sched->state = SAMPLING_OFF_WRIST;
+            return SAMPLING_SUSPEND;
+        }
+        if(sched->sleepSamples >= SAMPLING_DEEP_SLEEP_SECONDS*SAMPLE_RATE){
+            sched->state = SAMPLING_DEEP_SLEEP;
+            return SAMPLING_SUSPEND;
+        }
+        bool longQuiet = sched->quietSamples >= SAMPLING_QUIET_SECONDS*SAMPLE_RATE;
+        wanted = (isSleeping || longQuiet) ? SAMPLING_IDLE_BATCH : sched->batchSize;
+    }
+
+    if(wanted == sched->batchSize){
+        return 0;
+    }
+    sched->batchSize = wanted;
+    return wanted;
+}
+
+uint16_t sampling_resume(SamplingScheduler* sched) {
+    sampling_init(sched);
+    return sched->batchSize;
+}
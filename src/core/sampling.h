@@ -0,0 +1,55 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+
+// Picks the accelerometer batch size from what the wearer is doing. 10 Hz is the lowest rate
+// the accelerometer has, so the only thing left to save on is the number of wakeups: while
+// asleep, off the wrist or sitting still for a long time the handler gets 25 samples at once
+// instead of 10. The first batch with real motion in it switches back to 10-sample batches.
+//
+// Off the wrist or deep asleep even that is too much, so the stream stops altogether: the
+// worker unsubscribes the data service and waits for a tap (any sharp move) to start it again.
+// Off the wrist is a magnitude that stays flat to a few mg for SAMPLING_OFF_WRIST_SECONDS, no
+// arm is that still while awake. Deep sleep is SAMPLING_DEEP_SLEEP_SECONDS of quiet batches in
+// minutes that count as sleep. The minutes without samples count as quiet ones.
+
+#define SAMPLING_ACTIVE_BATCH 10
+#define SAMPLING_IDLE_BATCH 25
+
+// Max - min magnitude within a batch below which nothing is going on, mg. Walking is
+// 300 and more, sitting with some hand moves 50-150, the watch on a table under 10.
+#define SAMPLING_QUIET_MOTION 40
+// Seconds of quiet before switching to big batches when not asleep
+#define SAMPLING_QUIET_SECONDS 60
+
+// Max - min magnitude within a batch of a watch that lies somewhere, mg
+#define SAMPLING_OFF_WRIST_MOTION 10
+#define SAMPLING_OFF_WRIST_SECONDS (10*60)
+#define SAMPLING_DEEP_SLEEP_SECONDS (20*60)
+
+// sampling_update() result: stop the stream until motion
+#define SAMPLING_SUSPEND UINT16_MAX
+
+typedef enum {
+    SAMPLING_STREAMING,
+    SAMPLING_OFF_WRIST,     // suspended
+    SAMPLING_DEEP_SLEEP,    // suspended
+} SamplingState;
+
+typedef struct {
+    uint16_t batchSize;
+    uint16_t quietSamples;  // samples since the last batch with motion
+    uint16_t stillSamples;  // samples since the last batch that wasn't flat
+    uint16_t sleepSamples;  // quiet samples while sleeping, in a row
+    SamplingState state;
+} SamplingScheduler;
+
+void sampling_init(SamplingScheduler* sched);
+
+// Feeds the result of the last batch. Returns the new batch size if it has to change,
+// SAMPLING_SUSPEND if the stream should stop, 0 otherwise.
+uint16_t sampling_update(SamplingScheduler* sched, uint32_t steps, const BatchStats* stats, bool isSleeping);
+
+// Motion after a suspend, returns the batch size to start the stream with
+uint16_t sampling_resume(SamplingScheduler* sched);
@@ -0,0 +1,201 @@
+#include "sleep.h"
+
+// Run byte: level in the top 3 bits, run length - 1 in the low 5
+#define RUN_BITS 5
+#define RUN_MAX (1 << RUN_BITS)
+#define LEVEL_MAX 7
+
+// Mean batch motion (max - min magnitude over 10 samples, mg) of the first level, each one above
+// is twice that: 20, 40, 80... Under 20 the arm was still, a watch on a table is under 10 and
+// breathing barely moves a wrist. Walking is level 5 and up.
+#define LEVEL_BASE 20
+#define EPOCH_BATCHES (SLEEP_EPOCH_SAMPLES/10)
+
+// Cole-Kripke weights of the minutes -4..+2. The activity of a minute is the levels of its two
+// epochs added, 0..14, SLEEP_THRESHOLD is in weights times that.
+static const uint16_t WEIGHTS[7] = { 404, 598, 326, 441, 1408, 508, 350 };
+#define WINDOW 7
+#define AHEAD 2
+
+void sleep_init(SleepRecorder* sleep) {
+    memset(sleep, 0, sizeof(*sleep));
+}
+
+static uint8_t level_of(uint32_t motion) {
+    // Samples that never came (a suspended stream) count as still ones
+    motion /= EPOCH_BATCHES;
+    uint8_t level = 0;
+    while(motion >= LEVEL_BASE && level < LEVEL_MAX){
+        level++;
+        motion >>= 1;
+    }
+    return level;
+}
+
+static void add_epoch(SleepRecorder* sleep, uint8_t level) {
+    if(sleep->full){
+        return;
+    }
+    uint8_t* last = sleep->used ? &sleep->buf[sleep->used - 1] : NULL;
+    if(last && (*last >> RUN_BITS) == level && (*last & (RUN_MAX - 1)) < RUN_MAX - 1){
+        (*last)++;
+        return;
+    }
+    if(sleep->used == SLEEP_BUFFER){
+        sleep->full = true;
+        return;
+    }
+    sleep->buf[sleep->used++] = level << RUN_BITS;
+}
+
+static void close_epoch(SleepRecorder* sleep) {
+    uint8_t level = level_of(sleep->epochMotion);
+    add_epoch(sleep, level);
+    sleep->minuteActivity += level;
+    sleep->epochMotion = 0;
+    sleep->epochSamples = 0;
+    sleep->epochsThisMinute++;
+}
+
+void sleep_add_batch(SleepRecorder* sleep, const BatchStats* stats) {
+    if(!sleep->recording){
+        return;
+    }
+    sleep->epochMotion += (uint32_t) stats->motion*stats->samples/10;
+    sleep->epochSamples += stats->samples;
+    if(sleep->epochSamples >= SLEEP_EPOCH_SAMPLES && sleep->epochsThisMinute < 2){
+        close_epoch(sleep);
+    }
+}
+
+static void start(SleepRecorder* sleep, uint32_t minute) {
+    sleep_init(sleep);
+    sleep->recording = true;
+    sleep->start = minute;
+}
+
+bool sleep_minute(SleepRecorder* sleep, uint32_t minute, int hour, bool walking, SleepReport* report) {
+    bool night = hour >= SLEEP_RECORD_HOUR || hour < SLEEP_EARLIEST_HOUR;
+    if(!sleep->recording){
+        if(night){
+            start(sleep, minute);
+        }
+        return false;
+    }
+
+    // Two epochs a minute whatever came in, a suspended stream was a still one
+    while(sleep->epochsThisMinute < 2){
+        close_epoch(sleep);
+    }
+    sleep->epochsThisMinute = 0;
+    sleep->stillMinutes = sleep->minuteActivity ? 0 : sleep->stillMinutes + 1;
+    sleep->minuteActivity = 0;
+    if(sleep->stillMinutes >= SLEEP_RUN_MINUTES){
+        sleep->settled = true;
+    }else if(!sleep->settled && walking){
+        // Still up, the evening so far is of no use to the scoring
+        start(sleep, minute);
+        return false;
+    }
+
+    sleep->upMinutes = walking ? sleep->upMinutes + 1 : 0;
+    bool up = !night && sleep->upMinutes >= SLEEP_UP_MINUTES;
+    if(up || sleep->full || (hour >= SLEEP_LATEST_HOUR && hour < SLEEP_RECORD_HOUR)){
+        sleep_score(sleep, report);
+        sleep->recording = false;
+        return true;
+    }
+    return false;
+}
+
+typedef struct {
+    SleepReport* report;
+    uint32_t minute;            // being scored
+    uint32_t runStart;
+    bool runAsleep;
+    uint16_t pendingRestless;   // awake minutes after the last long sleep run
+    uint8_t pendingPeriods;
+} Scorer;
+
+// End of a run of minutes scored the same
+static void end_run(Scorer* s) {
+    uint32_t length = s->minute - s->runStart;
+    SleepReport* r = s->report;
+    if(s->runAsleep && length >= SLEEP_RUN_MINUTES){
+        if(!r->onset){
+            r->onset = s->runStart;
+        }else{
+            r->restlessMinutes += s->pendingRestless;
+            r->restlessPeriods += s->pendingPeriods;
+        }
+        r->wake = s->minute;
+        s->pendingRestless = 0;
+        s->pendingPeriods = 0;
+    }else if(!s->runAsleep && r->onset){
+        s->pendingRestless += length;
+        s->pendingPeriods++;
+    }
+}
+
+static void score_minute(Scorer* s, bool asleep) {
+    if(s->minute > s->runStart && asleep != s->runAsleep){
+        end_run(s);
+        s->runStart = s->minute;
+    }
+    s->runAsleep = asleep;
+    s->minute++;
+}
+
+void sleep_score(const SleepRecorder* sleep, SleepReport* report) {
+    memset(report, 0, sizeof(*report));
+    report->start = sleep->start;
+    report->bytes = sleep->used;
+
+    Scorer s = {
+        .report = report,
+        .minute = sleep->start,
+        .runStart = sleep->start,
+    };
+    // Activity of the last WINDOW minutes, the one being scored is AHEAD back from the newest
+    uint8_t window[WINDOW] = { 0 };
+    uint32_t minutes = 0;
+    uint8_t half = 0;           // first epoch of the minute being put together
+    bool odd = false;
+
+    for(uint16_t i = 0; i <= sleep->used; i++){
+        // One past the end pushes the last AHEAD minutes out with still ones after them
+        uint8_t level = i < sleep->used ? sleep->buf[i] >> RUN_BITS : 0;
+        uint16_t epochs = i < sleep->used ? (sleep->buf[i] & (RUN_MAX - 1)) + 1 : 2*AHEAD;
+        for(uint16_t e = 0; e < epochs; e++){
+            if(!odd){
+                half = level;
+                odd = true;
+                continue;
+            }
+            odd = false;
+            memmove(window, window + 1, WINDOW - 1);
+            window[WINDOW - 1] = half + level;
+            if(++minutes <= AHEAD){
+                continue;
+            }
+            uint32_t sum = 0;
+            for(int k = 0; k < WINDOW; k++){
+                sum += WEIGHTS[k]*window[k];
+            }
+            score_minute(&s, sum < SLEEP_THRESHOLD);
+        }
+    }
+    end_run(&s);
+
+    if(report->onset){
+        report->sleepMinutes = report->wake - report->onset - report->restlessMinutes;
+    }
+}
+
+void sleep_save(const SleepReport* report) {
+    persist_write_data(SLEEP_KEY, report, sizeof(*report));
+}
+
+bool sleep_load(SleepReport* report) {
+    return persist_read_data(SLEEP_KEY, report, sizeof(*report)) == sizeof(*report);
+}
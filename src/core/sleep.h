@@ -0,0 +1,73 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+
+// Overnight actigraphy. From SLEEP_RECORD_HOUR on, the motion of every 30 s epoch is quantized
+// to 0..7 and kept run-length encoded, a byte per run of up to 32 epochs at one level. A still
+// night is a few hundred bytes. Walking restarts the recording until the first SLEEP_RUN_MINUTES
+// without any motion, so the evening before going to bed doesn't take up the buffer.
+// In the morning, once the wearer walks (or at SLEEP_LATEST_HOUR), one pass over the runs
+// scores every minute Cole-Kripke style: a weighted sum of the minute's activity and of the 4
+// before and 2 after it, below SLEEP_THRESHOLD is asleep. Onset is where the first
+// SLEEP_RUN_MINUTES of sleep in a row start, wake where the last such run ends, the awake runs
+// in between are the restless periods. The report goes to persistent storage.
+//
+// Nothing but the run buffer is kept per epoch, the scoring pass keeps a 7 minute window, so RAM
+// is bounded at SLEEP_BUFFER plus 20 bytes however long the night. A night that doesn't fit
+// (over 6 h of fidgeting) is scored up to where the buffer filled.
+
+#define SLEEP_EPOCH_SAMPLES 300     // 30 s at 10 Hz
+#define SLEEP_BUFFER 768
+
+#define SLEEP_RECORD_HOUR 21        // recording runs from this hour...
+#define SLEEP_EARLIEST_HOUR 5       // ...and walking ends it from this one on
+#define SLEEP_LATEST_HOUR 12        // scored at this hour at the latest
+#define SLEEP_UP_MINUTES 3          // minutes with walking in a row that mean the night is over
+
+#define SLEEP_RUN_MINUTES 10        // sleep in a row that makes an onset
+#define SLEEP_THRESHOLD 6000        // weighted activity below which a minute is asleep
+
+#define SLEEP_KEY 31
+
+typedef struct {
+    uint32_t start;             // wall clock minute the recording started, 0 = no report
+    uint32_t onset;             // minutes, 0 if no sleep was found
+    uint32_t wake;
+    uint16_t sleepMinutes;      // onset to wake minus the restless minutes
+    uint16_t restlessMinutes;
+    uint8_t restlessPeriods;
+    uint8_t reserved;
+    uint16_t bytes;             // of the run buffer the night took
+} SleepReport;
+
+typedef struct {
+    bool recording;
+    uint8_t upMinutes;          // walking minutes in a row
+    uint8_t epochsThisMinute;
+    uint8_t minuteActivity;     // levels of the epochs of this minute added
+    uint8_t stillMinutes;       // in a row
+    bool settled;               // there was a still stretch, walking no longer restarts
+    uint16_t epochSamples;
+    uint32_t epochMotion;       // batch motion, mg, summed per 10 samples
+    uint32_t start;             // wall clock minute of the first epoch
+    uint16_t used;              // bytes of buf
+    bool full;
+    uint8_t buf[SLEEP_BUFFER];
+} SleepRecorder;
+
+void sleep_init(SleepRecorder* sleep);
+
+// The detector's view of one batch
+void sleep_add_batch(SleepRecorder* sleep, const BatchStats* stats);
+
+// Minute tick, after the batches of the minute. minute is time(NULL)/60, walking whether the
+// minute that ended had real walking in it. Returns true when the night was just scored into
+// report.
+bool sleep_minute(SleepRecorder* sleep, uint32_t minute, int hour, bool walking, SleepReport* report);
+
+// The scoring pass on its own, for the host tools
+void sleep_score(const SleepRecorder* sleep, SleepReport* report);
+
+void sleep_save(const SleepReport* report);
+bool sleep_load(SleepReport* report);
@@ -0,0 +1,109 @@
+#include "stats.h"
+
+// What is persisted, the window sums are not
+typedef struct {
+    DayStats days[STATS_DAYS];
+    uint8_t head;
+    uint8_t count;
+} StatsBlob;
+
+static inline const DayStats* day_back(const DailyStats* stats, int back) {
+    return &stats->days[(stats->head + STATS_DAYS - back) % STATS_DAYS];
+}
+
+#define WEEK (1 << 0)
+#define MONTH (1 << 1)
+
+// Adds (sign 1) or removes (sign -1) a day to/from the window sums
+static void apply(DailyStats* stats, const DayStats* d, int sign, int windows) {
+    if(windows & MONTH){
+        stats->steps30 += sign*(int32_t) d->steps;
+        stats->active30 += sign*(int32_t) d->activeMinutes;
+        stats->hits30 += sign*(int32_t) d->goalHit;
+    }
+    if(windows & WEEK){
+        stats->steps7 += sign*(int32_t) d->steps;
+        stats->active7 += sign*(int32_t) d->activeMinutes;
+        stats->hits7 += sign*(int32_t) d->goalHit;
+    }
+}
+
+void stats_init(DailyStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void stats_load(DailyStats* stats) {
+    StatsBlob blob;
+    stats_init(stats);
+    if(persist_read_data(STATS_KEY, &blob, sizeof(blob)) != sizeof(blob)
+            || blob.head >= STATS_DAYS || blob.count > STATS_DAYS){
+        return;
+    }
+    memcpy(stats->days, blob.days, sizeof(stats->days));
+    stats->head = blob.head;
+    stats->count = blob.count;
+    // The only full pass, once per worker start
+    for(int back=1;back<=stats->count;back++){
+        apply(stats, day_back(stats, back), 1, back <= STATS_WEEK ? WEEK | MONTH : MONTH);
+    }
+}
+
+void stats_save(const DailyStats* stats) {
+    StatsBlob blob;
+    memcpy(blob.days, stats->days, sizeof(blob.days));
+    blob.head = stats->head;
+    blob.count = stats->count;
+    persist_write_data(STATS_KEY, &blob, sizeof(blob));
+}
+
+void stats_minute(DailyStats* stats, bool sedentary) {
+    if(sedentary){
+        stats->sedentaryRun++;
+        if(stats->sedentaryRun > stats->sedentaryMax){
+            stats->sedentaryMax = stats->sedentaryRun;
+        }
+    }else{
+        stats->sedentaryRun = 0;
+    }
+}
+
+void stats_day_end(DailyStats* stats, uint32_t steps, uint32_t activeMinutes, uint32_t goal) {
+    DayStats d = {
+        .steps = steps > UINT16_MAX ? UINT16_MAX : steps,
+        .activeMinutes = activeMinutes,
+        .sedentaryMax = stats->sedentaryMax,
+        .goalHit = steps >= goal,
+    };
+
+    // The day a week ago leaves the week, the slot being reused leaves the month
+    if(stats->count >= STATS_WEEK){
+        apply(stats, day_back(stats, STATS_WEEK), -1, WEEK);
+    }
+    if(stats->count == STATS_DAYS){
+        apply(stats, &stats->days[stats->head], -1, MONTH);
+    }else{
+        stats->count++;
+    }
+    stats->days[stats->head] = d;
+    stats->head = (stats->head + 1) % STATS_DAYS;
+    apply(stats, &d, 1, WEEK | MONTH);
+
+    stats->sedentaryRun = 0;
+    stats->sedentaryMax = 0;
+}
+
+uint32_t stats_next_goal(const DailyStats* stats, uint32_t goal) {
+    uint8_t days = stats_week_days(stats);
+    if(days == 0){
+        return goal;
+    }
+    if(stats->hits7*2 > days){
+        goal = goal*105/100;
+    }else if(stats->hits7*3 < days){
+        goal = goal*95/100;
+    }
+    if(goal < STATS_GOAL_MIN){
+        goal = STATS_GOAL_MIN;
+    }
+    return goal/10*10;
+}
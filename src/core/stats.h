@@ -0,0 +1,67 @@
+#pragma once
+
+#include "platform.h"
+
+// Rolling statistics over the last 7 and 30 days. Every finished day goes into a ring of
+// STATS_DAYS records and the window sums are updated by adding it and subtracting the days
+// that fall out, so the day rollover costs the same no matter how much history there is.
+// The smiley and the goal adjustment read the windows instead of lifetime counters: a bad
+// week a year ago doesn't count anymore. ~270 bytes of RAM, the ring is one 242 byte blob in
+// persistent storage.
+
+#define STATS_DAYS 30
+#define STATS_WEEK 7
+
+#define STATS_KEY 30
+
+// The goal never goes below this however bad the weeks get
+#define STATS_GOAL_MIN 2000
+
+typedef struct {
+    uint16_t steps;             // capped at 65535
+    uint16_t activeMinutes;
+    uint16_t sedentaryMax;      // longest run of inactive minutes
+    uint8_t goalHit;
+    uint8_t reserved;
+} DayStats;
+
+typedef struct {
+    DayStats days[STATS_DAYS];
+    uint8_t head;               // slot the next day goes to
+    uint8_t count;              // days in the ring
+
+    // Window sums, rebuilt from the ring on load
+    uint32_t steps7;
+    uint32_t steps30;
+    uint16_t active7;
+    uint16_t active30;
+    uint8_t hits7;
+    uint8_t hits30;
+
+    // Today so far
+    uint16_t sedentaryRun;
+    uint16_t sedentaryMax;
+} DailyStats;
+
+void stats_init(DailyStats* stats);
+void stats_load(DailyStats* stats);
+void stats_save(const DailyStats* stats);
+
+// One minute of today, sedentary as activity_minute() counts it
+void stats_minute(DailyStats* stats, bool sedentary);
+
+// Closes the day: pushes it into the windows and starts a new one
+void stats_day_end(DailyStats* stats, uint32_t steps, uint32_t activeMinutes, uint32_t goal);
+
+// Goal for the next day from the week's hit rate: up 5% when more than half of the days made it,
+// down 5% when less than a third did, unchanged in between. Rounded to 10.
+uint32_t stats_next_goal(const DailyStats* stats, uint32_t goal);
+
+// Days in the 7 and 30 day windows so far, fewer in the first month
+static inline uint8_t stats_week_days(const DailyStats* stats) {
+    return stats->count < STATS_WEEK ? stats->count : STATS_WEEK;
+}
+
+static inline uint8_t stats_month_days(const DailyStats* stats) {
+    return stats->count;
+}
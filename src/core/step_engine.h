@@ -0,0 +1,37 @@
+#pragma once
+
+// Which step engine the worker runs, picked at build time so the others aren't called:
+// add STEP_ENGINE=1 (cadence), 2 (ratio) or 3 (gait) to the worker defines in the wscript to switch.
+// tools/replay runs any of them on the same traces (-e peak|ratio|cadence|gait).
+
+#include "detector.h"
+#include "cadence.h"
+#include "ratio_detector.h"
+#include "gait.h"
+
+#define STEP_ENGINE_PEAK 0
+#define STEP_ENGINE_CADENCE 1
+#define STEP_ENGINE_RATIO 2      // the old processAccelerometerDataWorking()
+#define STEP_ENGINE_GAIT 3       // three axes, knows a car from a walk
+
+#ifndef STEP_ENGINE
+#define STEP_ENGINE STEP_ENGINE_PEAK
+#endif
+
+#if STEP_ENGINE == STEP_ENGINE_CADENCE
+typedef CadenceDetector StepEngine;
+#define step_engine_init(engine) cadence_init(engine)
+#define step_engine_process(engine, data, size, stats) cadence_process(engine, data, size, stats)
+#elif STEP_ENGINE == STEP_ENGINE_GAIT
+typedef GaitDetector StepEngine;
+#define step_engine_init(engine) gait_init(engine)
+#define step_engine_process(engine, data, size, stats) gait_process(engine, data, size, stats)
+#elif STEP_ENGINE == STEP_ENGINE_RATIO
+typedef RatioDetector StepEngine;
+#define step_engine_init(engine) ratio_detector_init(engine)
+#define step_engine_process(engine, data, size, stats) ratio_detector_process(engine, data, size, stats)
+#else
+typedef StepDetector StepEngine;
+#define step_engine_init(engine) detector_init(engine, NULL)
+#define step_engine_process(engine, data, size, stats) detector_process(engine, data, size, stats)
+#endif
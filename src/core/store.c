@@ -0,0 +1,114 @@
+#include "store.h"
+
+// Keys of the values before the store, only read to migrate them
+#define KEY_DAYS_NO 1
+#define KEY_DAYS_YES 2
+#define KEY_TOTAL_STEPS 5
+#define KEY_SEGMENTS_INACTIVE 6
+#define KEY_ACTIVE_MINUTES 7
+#define KEY_OLD_STEPS 8
+#define KEY_DAY_NUMBER 9
+#define KEY_DAILY_GOAL 10
+
+// A change of the checkpoint has to come with a new STORE_VERSION
+_Static_assert(sizeof(ActivityCheckpoint) == 24, "ActivityCheckpoint layout changed");
+_Static_assert(sizeof(StoreRecord) == 32, "StoreRecord layout changed");
+
+// Fletcher-16, cheap and catches what a torn or stale write looks like. The sum starts at
+// seq, after the header fields it is stored in.
+static uint16_t checksum(const void* record, size_t size) {
+    const uint8_t* data = (const uint8_t*) record + offsetof(StoreRecord, seq);
+    size -= offsetof(StoreRecord, seq);
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    for(size_t i=0;i<size;i++){
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (sum2 << 8) | sum1;
+}
+
+static bool read_slot(uint32_t key, StoreRecord* record) {
+    return persist_read_data(key, record, sizeof(*record)) == sizeof(*record)
+            && record->version == STORE_VERSION
+            && record->checksum == checksum(record, sizeof(*record));
+}
+
+static int read_legacy(uint32_t key, int def) {
+    return persist_exists(key) ? persist_read_int(key) : def;
+}
+
+static void migrate(ActivityCheckpoint* state) {
+    state->daysNo = read_legacy(KEY_DAYS_NO, 1);
+    state->daysYes = read_legacy(KEY_DAYS_YES, 1);
+    state->totalSteps = read_legacy(KEY_TOTAL_STEPS, 0);
+    state->segmentsInactive = read_legacy(KEY_SEGMENTS_INACTIVE, 0);
+    if(state->segmentsInactive > 90){
+        state->segmentsInactive = 90;
+    }
+    state->activeMinutes = read_legacy(KEY_ACTIVE_MINUTES, 0);
+    state->oldSteps = read_legacy(KEY_OLD_STEPS, 0);
+    state->dayNumber = read_legacy(KEY_DAY_NUMBER, ACTIVITY_NO_DAY);
+    state->dailyGoal = read_legacy(KEY_DAILY_GOAL, 8250);
+}
+
+static void delete_legacy(void) {
+    static const uint32_t keys[] = {
+        KEY_DAYS_NO, KEY_DAYS_YES, KEY_TOTAL_STEPS, KEY_SEGMENTS_INACTIVE,
+        KEY_ACTIVE_MINUTES, KEY_OLD_STEPS, KEY_DAY_NUMBER, KEY_DAILY_GOAL,
+    };
+    for(size_t i=0;i<sizeof(keys)/sizeof(keys[0]);i++){
+        persist_delete(keys[i]);
+    }
+}
+
+void store_load(Store* store, ActivityState* state) {
+    StoreRecord slot0;
+    StoreRecord slot1;
+    bool ok0 = read_slot(STORE_KEY_SLOT0, &slot0);
+    bool ok1 = read_slot(STORE_KEY_SLOT1, &slot1);
+
+    if(!ok0 && !ok1){
+        migrate(&state->saved);
+        store->seq = 0;
+        store_save(store, state);
+        delete_legacy();
+        return;
+    }
+
+    // Newest of the good ones, the difference is signed so it survives the wrap
+    const StoreRecord* r = &slot0;
+    if(!ok0 || (ok1 && (int32_t) (slot1.seq - slot0.seq) > 0)){
+        r = &slot1;
+    }
+    memcpy(&state->saved, &r->saved, sizeof(state->saved));
+
+    store->seq = r->seq;
+    store->savedSteps = r->saved.totalSteps;
+    store->minutes = 0;
+}
+
+void store_save(Store* store, const ActivityState* state) {
+    StoreRecord r = {
+        .version = STORE_VERSION,
+        .seq = ++store->seq,
+    };
+    memcpy(&r.saved, &state->saved, sizeof(r.saved));
+    r.checksum = checksum(&r, sizeof(r));
+
+    // Odd sequence numbers go to one slot, even to the other, so the last good
+    // checkpoint is never the one being overwritten
+    persist_write_data((r.seq & 1) ? STORE_KEY_SLOT1 : STORE_KEY_SLOT0, &r, sizeof(r));
+    store->savedSteps = state->saved.totalSteps;
+    store->minutes = 0;
+}
+
+bool store_minute(Store* store, const ActivityState* state) {
+    store->minutes++;
+    if(store->minutes >= STORE_CHECKPOINT_MINUTES
+            || state->saved.totalSteps - store->savedSteps >= STORE_CHECKPOINT_STEPS){
+        store_save(store, state);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "platform.h"
+#include "activity.h"
+
+// The worker state in one persistent blob instead of a key per value. It is written as a
+// checkpoint every STORE_CHECKPOINT_MINUTES or STORE_CHECKPOINT_STEPS, on the day rollover and
+// on exit, so a crash or a flat battery loses minutes, not the whole day.
+// Checkpoints alternate between two keys and carry a sequence number and a checksum: a write
+// torn halfway leaves the previous checkpoint intact and the loader picks the newest good one.
+
+#define STORE_VERSION 2
+
+#define STORE_KEY_SLOT0 20
+#define STORE_KEY_SLOT1 21
+
+#define STORE_CHECKPOINT_MINUTES 10
+#define STORE_CHECKPOINT_STEPS 500
+
+// What goes to flash: a header and the state's checkpoint as it is in RAM, 32 bytes.
+// The checksum covers everything after it.
+typedef struct {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t checksum;
+    uint32_t seq;
+    ActivityCheckpoint saved;
+} StoreRecord;
+
+typedef struct {
+    uint32_t seq;               // of the last checkpoint written or loaded
+    uint32_t savedSteps;        // totalSteps at that checkpoint
+    uint16_t minutes;           // minutes since it
+} Store;
+
+// Loads the newest valid checkpoint into state. Without one, reads the values from the
+// keys the app used before and saves them as the first checkpoint.
+void store_load(Store* store, ActivityState* state);
+
+// Called every minute, writes a checkpoint when one is due. Returns true if it did.
+// Not meant for the minute the day rolls over, that one is saved right away.
+bool store_minute(Store* store, const ActivityState* state);
+
+void store_save(Store* store, const ActivityState* state);
@@ -0,0 +1,107 @@
+#include "sync.h"
+
+static size_t put_varint(uint8_t* buf, uint32_t value) {
+    size_t n = 0;
+    while(value >= 0x80){
+        buf[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buf[n++] = value;
+    return n;
+}
+
+static size_t get_varint(const uint8_t* buf, size_t size, uint32_t* value) {
+    uint32_t v = 0;
+    for(size_t n = 0; n < size && n < SYNC_VARINT_MAX; n++){
+        v |= (uint32_t) (buf[n] & 0x7F) << (7*n);
+        if(!(buf[n] & 0x80)){
+            *value = v;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+void sync_start(SyncSession* sync, const History* live, uint32_t from) {
+    history_reader_open(&sync->reader, live);
+    const HistoryMeta* meta = &sync->reader.meta;
+
+    // Same window history_reader_get() answers for
+    uint32_t kept = meta->head < HISTORY_MINUTES - HISTORY_MINUTES_PER_CHUNK
+                  ? meta->head : HISTORY_MINUTES - HISTORY_MINUTES_PER_CHUNK;
+    uint32_t oldest = meta->headTime - kept;
+    sync->from = from;
+    sync->end = meta->headTime;
+    sync->next = from > oldest ? from : oldest;
+    if(sync->next > sync->end){
+        // The clock went back since the phone last synced
+        sync->next = sync->end;
+    }
+    sync->acked = sync->next;
+    sync->unacked = 0;
+}
+
+size_t sync_next_chunk(SyncSession* sync, uint8_t* buf, size_t size) {
+    if(sync->unacked >= SYNC_WINDOW || sync->next >= sync->end || size < 2*SYNC_VARINT_MAX){
+        return 0;
+    }
+    size_t len = put_varint(buf, sync->next - sync->from);
+    uint32_t minute = sync->next;
+    while(minute < sync->end && len + SYNC_VARINT_MAX <= size){
+        int level = history_reader_get(&sync->reader, minute);
+        uint32_t run = 1;
+        while(minute + run < sync->end && history_reader_get(&sync->reader, minute + run) == level){
+            run++;
+        }
+        len += put_varint(buf + len, run << 2 | level);
+        minute += run;
+    }
+    sync->next = minute;
+    sync->inflight[sync->unacked++] = minute;
+    return len;
+}
+
+void sync_ack(SyncSession* sync, uint32_t minute) {
+    if(minute <= sync->acked || minute > sync->next){
+        return;     // stale or nonsense
+    }
+    sync->acked = minute;
+    // The chunks that ended by then are off the window
+    uint8_t kept = 0;
+    for(uint8_t i = 0; i < sync->unacked; i++){
+        if(sync->inflight[i] > minute){
+            sync->inflight[kept++] = sync->inflight[i];
+        }
+    }
+    sync->unacked = kept;
+}
+
+void sync_rewind(SyncSession* sync) {
+    sync->next = sync->acked;
+    sync->unacked = 0;
+}
+
+uint32_t sync_decode(const uint8_t* buf, size_t size, uint32_t from, SyncRunCallback run, void* context) {
+    uint32_t value;
+    size_t n = get_varint(buf, size, &value);
+    if(n == 0){
+        return 0;
+    }
+    uint32_t minute = from + value;
+    while(n < size){
+        size_t k = get_varint(buf + n, size - n, &value);
+        if(k == 0 || (value >> 2) == 0){
+            return 0;
+        }
+        run(context, minute, value >> 2, (HistoryLevel) (value & 3));
+        minute += value >> 2;
+        n += k;
+    }
+    return minute;
+}
+
+uint32_t sync_chunk_start(const uint8_t* buf, size_t size, uint32_t from) {
+    uint32_t value = 0;
+    get_varint(buf, size, &value);
+    return from + value;
+}
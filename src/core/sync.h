@@ -0,0 +1,64 @@
+#pragma once
+
+#include "platform.h"
+#include "history.h"
+
+// Ships the per-minute history to the phone. The phone asks for everything from a minute on,
+// the watch answers with chunks that each fill one AppMessage, the phone acknowledges every
+// SYNC_WINDOW chunks with the minute it has everything before. A send that fails goes back to
+// the last acknowledged minute; a disconnect just ends it, and the next request starts from
+// what the phone has, so nothing is kept on the watch between syncs. If the phone asks for
+// minutes the watch no longer keeps, the first chunk starts at the oldest one it has, the phone
+// takes that chunk wherever it starts and the minutes in between are a gap.
+//
+// A chunk is a list of varints, 7 bits each, low bits first:
+//   start - from       where the chunk starts, relative to the minute the phone asked for
+//   length << 2 | level    runs of minutes at the same HistoryLevel, until the chunk is full
+// A still night is a handful of bytes, a whole day usually fits in one or two chunks.
+
+// AppMessage keys, the same as appKeys in appinfo.json
+#define SYNC_KEY_FROM 1     // phone -> watch: send the minutes from this one on (time/60)
+#define SYNC_KEY_DATA 2     // watch -> phone: one chunk
+#define SYNC_KEY_ACK 3      // phone -> watch: has everything before this minute
+#define SYNC_KEY_END 4      // watch -> phone: no more minutes, this is where the history ends
+
+// Chunks in flight before the watch waits for an acknowledgement
+#define SYNC_WINDOW 4
+
+// Longest varint of a uint32
+#define SYNC_VARINT_MAX 5
+
+typedef struct {
+    HistoryReader reader;
+    uint32_t from;          // what the phone asked for, chunk starts are relative to it
+    uint32_t acked;         // the phone has everything before this minute
+    uint32_t next;          // first minute of the next chunk
+    uint32_t end;           // where the history ended when the request came
+    uint32_t inflight[SYNC_WINDOW];    // where each chunk not acknowledged yet ends
+    uint8_t unacked;
+} SyncSession;
+
+// A request from the phone. Minutes before the oldest one kept start at the oldest one.
+// live is the worker's History, or NULL to read what is persisted.
+void sync_start(SyncSession* sync, const History* live, uint32_t from);
+
+// Writes the next chunk into buf, at most size bytes. Returns its length, 0 when the window is
+// full or everything was sent.
+size_t sync_next_chunk(SyncSession* sync, uint8_t* buf, size_t size);
+
+void sync_ack(SyncSession* sync, uint32_t minute);
+
+// The last send failed, the chunks after the last acknowledgement go again
+void sync_rewind(SyncSession* sync);
+
+static inline bool sync_done(const SyncSession* sync) {
+    return sync->acked >= sync->end;
+}
+
+// The phone side, for the host tool. Calls run() for every run of minutes in the chunk and
+// returns the minute after the last one, 0 if the chunk is malformed.
+typedef void (*SyncRunCallback)(void* context, uint32_t start, uint32_t length, HistoryLevel level);
+uint32_t sync_decode(const uint8_t* buf, size_t size, uint32_t from, SyncRunCallback run, void* context);
+
+// First minute of the chunk
+uint32_t sync_chunk_start(const uint8_t* buf, size_t size, uint32_t from);
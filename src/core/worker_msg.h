@@ -0,0 +1,15 @@
+#pragma once
+
+// AppWorkerMessage types between the watchface and its background worker.
+// The worker owns the accelerometer and all the counters, the face only draws them.
+
+enum {
+    WORKER_MSG_REFRESH = 0,     // face -> worker: send everything, the face just started
+    WORKER_MSG_STEPS,           // data0/data1 = totalSteps low/high word, data2 = segmentsInactive
+    WORKER_MSG_GOAL,            // data0 = dailyGoal/10, data1/data2 = days the goal was hit/missed lately
+    WORKER_MSG_BUZZ,            // data0 = length of the reminder pulse, ms
+    WORKER_MSG_GOAL_REACHED,
+    WORKER_MSG_FLUSH_HISTORY,   // face -> worker: write the history out, the phone wants it
+    WORKER_MSG_HISTORY_FLUSHED, // worker -> face: done, persistent storage is up to date
+    WORKER_MSG_WORKOUT,         // data0 = cadence, spm, data1 = pace, s/km, data2 = 1 running, 0 it ended
+};
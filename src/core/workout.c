@@ -0,0 +1,78 @@
+#include "workout.h"
+#include "detector_pipeline.h"
+
+#define SLOW_RATE 10
+
+void workout_init(Workout* w) {
+    memset(w, 0, sizeof(*w));
+}
+
+uint16_t workout_cadence(const Workout* w) {
+    uint16_t sum = 0;
+    for(int i=0;i<WORKOUT_WINDOW;i++){
+        sum += w->steps[i];
+    }
+    return sum*60/WORKOUT_WINDOW;
+}
+
+uint16_t workout_pace(const Workout* w) {
+    uint32_t cadence = workout_cadence(w);
+    if(cadence == 0){
+        return 0;
+    }
+    // 1 km = 100000 cm, in seconds: 100000 / (cadence/60 * WORKOUT_STEP_CM)
+    uint32_t pace = 100000UL*60/(cadence*WORKOUT_STEP_CM);
+    return pace > UINT16_MAX ? UINT16_MAX : pace;
+}
+
+static uint32_t second(Workout* w) {
+    uint32_t events = 0;
+    w->steps[w->head] = w->stepsThisSecond > UINT8_MAX ? UINT8_MAX : w->stepsThisSecond;
+    w->head = (w->head + 1) % WORKOUT_WINDOW;
+    w->stepsThisSecond = 0;
+
+    bool fast = workout_cadence(w) >= WORKOUT_START_SPM;
+    w->fastSeconds = fast ? w->fastSeconds + 1 : 0;
+    w->slowSeconds = fast ? 0 : w->slowSeconds + 1;
+
+    if(!w->active && w->fastSeconds >= WORKOUT_START_SECONDS){
+        w->active = true;
+        w->reportIn = 0;
+        w->samples = 0;
+        events |= WORKOUT_STARTED;
+    }else if(w->active && w->slowSeconds >= WORKOUT_END_SECONDS){
+        w->active = false;
+        w->samples = 0;
+        events |= WORKOUT_ENDED;
+    }
+    if(w->active){
+        if(w->reportIn == 0){
+            w->reportIn = WORKOUT_REPORT_SECONDS;
+            events |= WORKOUT_REPORT;
+        }
+        w->reportIn--;
+    }
+    return events;
+}
+
+uint32_t workout_update(Workout* w, uint32_t steps, uint32_t samples) {
+    uint16_t rate = w->active ? WORKOUT_RATE : SLOW_RATE;
+    uint32_t events = 0;
+    w->stepsThisSecond += steps;
+    w->samples += samples;
+    // The rest of a long batch goes to the seconds after it without steps. A switch of the
+    // rate drops what is left, the batches at the new one start a new second.
+    while(w->samples >= rate){
+        w->samples -= rate;
+        events |= second(w);
+    }
+    return events;
+}
+
+static DETECTOR_DEFINE(detect, WORKOUT_DETECTOR)
+
+uint32_t workout_detect(StepDetector* det, const AccelData* data, uint32_t size, BatchStats* stats) {
+    uint32_t steps = detect(det, data, size, stats);
+    stats->samples = stats->samples*SLOW_RATE/WORKOUT_RATE;
+    return steps;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "platform.h"
+#include "detector.h"
+
+// Running mode. At 10 Hz a step at 200 spm is 3 samples, the peak detector's minimum gap, and
+// steps start to go missing. When the wearer keeps a running cadence for WORKOUT_START_SECONDS
+// the worker switches the accelerometer to WORKOUT_RATE Hz in full batches and runs
+// workout_detect() on it, a peak detector with its gaps scaled for that rate. Cadence and pace
+// go to the face every WORKOUT_REPORT_SECONDS. WORKOUT_END_SECONDS below the running cadence
+// and it is back on the 10 Hz path with the adaptive batches.
+//
+// Budget at 25 Hz (samples and wakeups exact, time measured on the host with tools/replay -e run):
+//   10 Hz:  36000 samples/h, 3600 wakeups/h of 10 samples (360 idle)
+//   25 Hz:  90000 samples/h, 3600 wakeups/h of 25 samples
+// The same number of wakeups, each one 2.5 times the samples; the detector costs about 0.4 us a
+// batch on the host either way. The accelerometer itself draws more at 25 Hz, that is the bigger
+// part of what a one-hour run costs and the SDK has no way to read it.
+
+#define WORKOUT_RATE 25
+#define WORKOUT_BATCH 25
+
+#define WORKOUT_START_SPM 140
+#define WORKOUT_START_SECONDS 20
+#define WORKOUT_END_SECONDS 120
+#define WORKOUT_REPORT_SECONDS 5
+
+// Cadence is taken over this many seconds
+#define WORKOUT_WINDOW 10
+
+// Pace from the cadence, there is no GPS: a running step of this length, cm
+#define WORKOUT_STEP_CM 100
+
+// Peak detector at WORKOUT_RATE Hz. The gaps are in samples: at least 0.24 s between peaks,
+// up to 250 spm, and a step every 0.9 s to keep the sequence going. The 3-tap average is a
+// shorter window at this rate, a shorter gap lets the bumps within one step count twice.
+#define WORKOUT_DETECTOR { \
+    .ratioNum = 21, \
+    .ratioDen = 20, \
+    .minAverage = 70, \
+    .minGap = 5, \
+    .maxGap = 22, \
+    .minRun = 7, \
+    .sleepEnergy = 10300, \
+}
+
+// workout_update() events
+#define WORKOUT_STARTED (1 << 0)
+#define WORKOUT_ENDED   (1 << 1)
+#define WORKOUT_REPORT  (1 << 2)
+
+typedef struct {
+    bool active;
+    uint16_t fastSeconds;   // seconds in a row at running cadence
+    uint16_t slowSeconds;   // seconds in a row below it
+    uint16_t samples;       // into the current second
+    uint16_t stepsThisSecond;
+    uint8_t steps[WORKOUT_WINDOW];  // steps of the last seconds
+    uint8_t head;
+    uint16_t reportIn;      // seconds to the next report
+} Workout;
+
+void workout_init(Workout* w);
+
+// Steps of one batch at the current rate (10 Hz or WORKOUT_RATE). Returns WORKOUT_* events
+// when a second completed with it.
+uint32_t workout_update(Workout* w, uint32_t steps, uint32_t samples);
+
+// Steps per minute over the last WORKOUT_WINDOW seconds
+uint16_t workout_cadence(const Workout* w);
+
+// Seconds per km at that cadence, 0 when standing
+uint16_t workout_pace(const Workout* w);
+
+// The running detector, same contract as detector_process(). BatchStats.samples is given in
+// 10 Hz samples so the minute bookkeeping doesn't notice the rate.
+uint32_t workout_detect(StepDetector* det, const AccelData* data, uint32_t size, BatchStats* stats);
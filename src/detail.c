@@ -0,0 +1,110 @@
+#include "detail.h"
+#include "core/stats.h"
+#include "core/sleep.h"
+
+// A night scored longer ago than this is not last night's
+#define DETAIL_NIGHT_MINUTES (18*60)
+
+static Window* s_window = NULL;
+static TextLayer* s_title_layer;
+static TextLayer* s_week_layer;
+static TextLayer* s_active_layer;
+static TextLayer* s_sleep_layer;
+static AppTimer* s_dismiss_timer = NULL;
+
+static char bufferWeek[32];
+static char bufferActive[24];
+static char bufferSleep[32];
+
+static void format_week(void) {
+    // The ring is only needed for the sums, it lives on the stack while they are formatted
+    DailyStats stats;
+    stats_load(&stats);
+    int days = stats_week_days(&stats);
+    if(days == 0){
+        snprintf(bufferWeek, sizeof(bufferWeek), "No full day yet");
+        bufferActive[0] = '\0';
+        return;
+    }
+    snprintf(bufferWeek, sizeof(bufferWeek), "%d steps\n%d a day", (int) stats.steps7, (int) (stats.steps7/days));
+    snprintf(bufferActive, sizeof(bufferActive), "%d min active", (int) stats.active7);
+}
+
+static void format_sleep(void) {
+    SleepReport night;
+    if(!sleep_load(&night) || !night.onset || time(NULL)/60 - night.wake > DETAIL_NIGHT_MINUTES){
+#if defined(PBL_HEALTH)
+        // The worker counts with HealthService where it can and records no nights then
+        if(health_service_metric_accessible(HealthMetricStepCount, time_start_of_today(), time(NULL))
+                & HealthServiceAccessibilityMaskAvailable){
+            snprintf(bufferSleep, sizeof(bufferSleep), "Sleep is in\nPebble Health");
+            return;
+        }
+#endif
+        snprintf(bufferSleep, sizeof(bufferSleep), "No night recorded");
+        return;
+    }
+    snprintf(bufferSleep, sizeof(bufferSleep), "Slept %d:%.2d\n%d restless", night.sleepMinutes/60,
+            night.sleepMinutes%60, night.restlessPeriods);
+}
+
+static TextLayer* create_text_layer(Window* window, GRect frame, const char* font, const char* text) {
+    TextLayer* layer = text_layer_create(frame);
+    text_layer_set_background_color(layer, GColorClear);
+    text_layer_set_text_color(layer, GColorBlack);
+    text_layer_set_font(layer, fonts_get_system_font(font));
+    text_layer_set_text_alignment(layer, GTextAlignmentLeft);
+    text_layer_set_text(layer, text);
+    layer_add_child(window_get_root_layer(window), text_layer_get_layer(layer));
+    return layer;
+}
+
+static void window_load(Window* window) {
+    format_week();
+    format_sleep();
+    s_title_layer = create_text_layer(window, GRect(6, 2, 132, 22), FONT_KEY_GOTHIC_18_BOLD, "Last 7 days");
+    s_week_layer = create_text_layer(window, GRect(6, 22, 132, 56), FONT_KEY_GOTHIC_24_BOLD, bufferWeek);
+    s_active_layer = create_text_layer(window, GRect(6, 78, 132, 28), FONT_KEY_GOTHIC_24_BOLD, bufferActive);
+    s_sleep_layer = create_text_layer(window, GRect(6, 110, 132, 56), FONT_KEY_GOTHIC_24_BOLD, bufferSleep);
+}
+
+// Everything goes, the face is left with what it had before the flick
+static void window_unload(Window* window) {
+    if(s_dismiss_timer){
+        app_timer_cancel(s_dismiss_timer);
+        s_dismiss_timer = NULL;
+    }
+    text_layer_destroy(s_title_layer);
+    text_layer_destroy(s_week_layer);
+    text_layer_destroy(s_active_layer);
+    text_layer_destroy(s_sleep_layer);
+    window_destroy(s_window);
+    s_window = NULL;
+}
+
+static void dismiss_timer_callback(void* data) {
+    s_dismiss_timer = NULL;
+    window_stack_remove(s_window, true);
+}
+
+void detail_show(void) {
+    if(s_window && s_dismiss_timer){
+        app_timer_reschedule(s_dismiss_timer, DETAIL_TIMEOUT_MS);
+        return;
+    }
+    if(s_window){
+        // Dismissed and still sliding out, unload() hasn't run yet: bring it back
+        if(!window_stack_contains_window(s_window)){
+            window_stack_push(s_window, true);
+        }
+        s_dismiss_timer = app_timer_register(DETAIL_TIMEOUT_MS, dismiss_timer_callback, NULL);
+        return;
+    }
+    s_window = window_create();
+    window_set_window_handlers(s_window, (WindowHandlers) {
+        .load = window_load,
+        .unload = window_unload,
+    });
+    window_stack_push(s_window, true);
+    s_dismiss_timer = app_timer_register(DETAIL_TIMEOUT_MS, dismiss_timer_callback, NULL);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pebble.h>
+
+// The stats screen a flick of the wrist brings up over the face: steps and active minutes of
+// the last 7 days and last night's sleep, read from what the worker saved. Its window and
+// layers exist only while it is on screen, it goes away by itself after DETAIL_TIMEOUT_MS
+// and another flick while it is up keeps it there.
+
+#define DETAIL_TIMEOUT_MS 8000
+
+void detail_show(void);
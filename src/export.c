@@ -0,0 +1,146 @@
+#include "export.h"
+#include "core/sync.h"
+#include "core/worker_msg.h"
+
+#define DEBUG false
+
+// Biggest outbox asked for, the chunk buffer is this big
+#define EXPORT_OUTBOX_MAX 656
+#define EXPORT_INBOX_SIZE 64
+
+// A failed send is tried again after this, up to EXPORT_RETRIES times in a row
+#define EXPORT_RETRY_MS 2000
+#define EXPORT_RETRIES 5
+
+static SyncSession s_sync;
+static uint8_t s_chunk[EXPORT_OUTBOX_MAX];
+static size_t s_chunkSize;
+static bool s_active = false;
+static bool s_waitingFlush = false;
+static bool s_sending = false;
+static bool s_endSent = false;
+static uint32_t s_requested;
+static uint8_t s_failures = 0;
+static AppTimer* s_retry_timer = NULL;
+
+static void send_next(void) {
+    if(!s_active || s_sending || s_retry_timer){
+        return;
+    }
+    size_t len = sync_next_chunk(&s_sync, s_chunk, s_chunkSize);
+    bool end = len == 0 && s_sync.next >= s_sync.end;
+    if(len == 0 && (!end || s_endSent)){
+        return;     // waiting for the acknowledgement
+    }
+
+    DictionaryIterator* iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK){
+        sync_rewind(&s_sync);
+        return;
+    }
+    if(end){
+        dict_write_uint32(iter, SYNC_KEY_END, s_sync.end);
+        s_endSent = true;
+    }else{
+        dict_write_data(iter, SYNC_KEY_DATA, s_chunk, len);
+    }
+    if(app_message_outbox_send() == APP_MSG_OK){
+        s_sending = true;
+    }else{
+        sync_rewind(&s_sync);
+        s_endSent = false;
+    }
+}
+
+static void start(uint32_t from) {
+    sync_start(&s_sync, NULL, from);
+    s_active = true;
+    s_endSent = false;
+    s_failures = 0;
+    if (DEBUG) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "export: minutes %d..%d", (int) s_sync.next, (int) s_sync.end);
+    }
+    send_next();
+}
+
+void export_history_flushed(void) {
+    if(s_waitingFlush){
+        s_waitingFlush = false;
+        start(s_requested);
+    }
+}
+
+static void retry_timer_callback(void* data) {
+    s_retry_timer = NULL;
+    send_next();
+}
+
+static void inbox_received(DictionaryIterator* iter, void* context) {
+    Tuple* from = dict_find(iter, SYNC_KEY_FROM);
+    if(from){
+        // A new request replaces whatever was going on, the phone knows what it has
+        s_active = false;
+        s_requested = from->value->uint32;
+        if(app_worker_is_running()){
+            s_waitingFlush = true;
+            AppWorkerMessage msg = { 0 };
+            app_worker_send_message(WORKER_MSG_FLUSH_HISTORY, &msg);
+        }else{
+            start(s_requested);
+        }
+        return;
+    }
+    Tuple* ack = dict_find(iter, SYNC_KEY_ACK);
+    if(ack && s_active){
+        sync_ack(&s_sync, ack->value->uint32);
+        if(sync_done(&s_sync)){
+            s_active = false;
+            return;
+        }
+        send_next();
+    }
+}
+
+static void outbox_sent(DictionaryIterator* iter, void* context) {
+    s_sending = false;
+    s_failures = 0;
+    send_next();
+}
+
+static void outbox_failed(DictionaryIterator* iter, AppMessageResult reason, void* context) {
+    s_sending = false;
+    if(!s_active){
+        return;
+    }
+    // Gone or busy, go back to what the phone has and try again in a while. If it stays gone
+    // the phone asks again when it is back.
+    sync_rewind(&s_sync);
+    s_endSent = false;
+    if(++s_failures > EXPORT_RETRIES){
+        s_active = false;
+        return;
+    }
+    s_retry_timer = app_timer_register(EXPORT_RETRY_MS, retry_timer_callback, NULL);
+}
+
+void export_init(void) {
+    uint32_t outbox = app_message_outbox_size_maximum();
+    if(outbox > EXPORT_OUTBOX_MAX){
+        outbox = EXPORT_OUTBOX_MAX;
+    }
+    // What is left of the outbox with the one tuple in it
+    s_chunkSize = outbox - dict_calc_buffer_size(1, 0);
+
+    app_message_register_inbox_received(inbox_received);
+    app_message_register_outbox_sent(outbox_sent);
+    app_message_register_outbox_failed(outbox_failed);
+    app_message_open(EXPORT_INBOX_SIZE, outbox);
+}
+
+void export_deinit(void) {
+    if(s_retry_timer){
+        app_timer_cancel(s_retry_timer);
+        s_retry_timer = NULL;
+    }
+    app_message_deregister_callbacks();
+}
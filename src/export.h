@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pebble.h>
+
+// The AppMessage side of the history sync in core/sync.h. The phone asks, the worker is told
+// to flush what it has in RAM, then the chunks go out one at a time as the outbox frees up.
+
+void export_init(void);
+void export_deinit(void);
+
+// The worker wrote its history out, the pending request can go ahead
+void export_history_flushed(void);
@@ -0,0 +1,441 @@
+#include "face.h"
+#include "core/profile.h"
+
+#define DEBUG false
+
+// Renders are at most this often, changes in between are merged into one
+#define RENDER_INTERVAL_MS 1000
+
+// IMAGE_ATLAS: the three smileys stacked (18x18 each). The gauge is drawn, not a bitmap anymore.
+#define ATLAS_SMILEY(i) GRect(0, (i)*18, 18, 18)
+
+// The inactivity gauge: four arrow segments filling up as segmentsInactive goes to
+// GAUGE_FULL_MINUTES, one pixel of fill at a time. x and width of each outline, inside the layer.
+#define GAUGE_FRAME GRect(6, 29, 97, 8)
+#define GAUGE_SEGMENTS 4
+#define GAUGE_FULL_MINUTES 60
+static const uint8_t GAUGE_X[GAUGE_SEGMENTS] = { 2, 33, 54, 76 };
+static const uint8_t GAUGE_W[GAUGE_SEGMENTS] = { 28, 19, 20, 19 };
+#define GAUGE_FILL_PX (28 + 19 + 20 + 19 - 2*GAUGE_SEGMENTS)
+
+// Progress to the daily goal, a ring around the smiley filling clockwise from the top in
+// 5 degree arcs, over a one pixel track of the whole circle
+#define PROGRESS_FRAME GRect(7, 58, 24, 24)
+#define PROGRESS_RING_PX 2
+#define PROGRESS_FILL_ARCS 72
+
+// Everything shown on the face. s_wanted is what the setters asked for, s_shown what is on
+// screen, a field is redrawn only when the two differ.
+typedef struct {
+    uint32_t steps;
+    int inactive;
+    uint32_t goal;
+    int8_t smiley;          // 0 fun, 1 neutral, 2 sad
+    uint8_t gaugePx;        // pixels of the gauge filled, 0..GAUGE_FILL_PX
+    uint8_t progressArc;    // arcs of the goal ring filled, 0..PROGRESS_FILL_ARCS
+    int8_t battery;         // charge percent
+    bool charging;
+    int8_t hour;
+    int8_t minute;
+    int16_t yday;
+    bool workout;           // running, cadence and pace take the places of the date and the goal.
+                            // Never with HealthService, the worker has no samples to see a run in
+    uint16_t cadence;       // spm
+    uint16_t pace;          // s/km
+} FaceValues;
+
+static FaceValues s_wanted = {
+    .goal = 8250,
+    .smiley = 1,
+    .hour = -1,
+    .yday = -1,
+};
+static FaceValues s_shown;
+static struct tm s_time;
+
+static bool s_loaded = false;
+static AppTimer* s_render_timer = NULL;
+static time_t s_last_render_s = 0;
+static uint16_t s_last_render_ms = 0;
+
+// Instrumentation, see face_log_stats()
+static uint32_t s_renders = 0;
+static uint32_t s_layer_updates = 0;
+static uint32_t s_unchanged = 0;
+
+static char buffer[8];
+static char bufferActive[5];
+static char bufferDate[8];
+static char bufferGoal[8];
+static char bufferTime[] = "00:00";
+static char bufferBattery[5];
+
+static TextLayer *s_time_layer;
+static TextLayer *s_steps_layer;
+static TextLayer *s_active_layer;
+static TextLayer *s_battery_layer;
+static TextLayer *s_date_layer;
+static TextLayer *s_goal_layer;
+static GFont s_time_font;
+
+static BitmapLayer *s_background_layer;
+static GBitmap *s_background_bitmap;
+
+// One resource and one pixel buffer, the states are sub-bitmaps pointing into it
+static GBitmap *s_atlas_bitmap;
+
+static Layer *s_gauge_layer;
+static Layer *s_progress_layer;
+
+static BitmapLayer *s_performance_layer;
+static GBitmap *s_perf_bitmaps[3];
+
+// Arrow outline with the fill inside, the middle rows are a pixel to the right like the old bitmaps
+static void draw_gauge_segment(GContext* ctx, int x, int w, int fill) {
+    graphics_draw_line(ctx, GPoint(x, 1), GPoint(x + w - 3, 1));
+    graphics_draw_line(ctx, GPoint(x, 6), GPoint(x + w - 3, 6));
+    graphics_draw_pixel(ctx, GPoint(x, 2));
+    graphics_draw_pixel(ctx, GPoint(x, 5));
+    graphics_draw_line(ctx, GPoint(x + 1, 3), GPoint(x + 1, 4));
+    graphics_draw_pixel(ctx, GPoint(x + w - 2, 2));
+    graphics_draw_pixel(ctx, GPoint(x + w - 2, 5));
+    graphics_draw_line(ctx, GPoint(x + w - 1, 3), GPoint(x + w - 1, 4));
+    if(fill > 0){
+        graphics_fill_rect(ctx, GRect(x + 1, 2, fill, 4), 0, GCornerNone);
+    }
+}
+
+static void gauge_update_proc(Layer* layer, GContext* ctx) {
+    PROFILE_BEGIN(t);
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    int fill = s_wanted.gaugePx;
+    for(int i=0;i<GAUGE_SEGMENTS;i++){
+        int inner = GAUGE_W[i] - 2;
+        draw_gauge_segment(ctx, GAUGE_X[i], GAUGE_W[i], fill < inner ? fill : inner);
+        fill = fill > inner ? fill - inner : 0;
+    }
+    PROFILE_END(t, PROFILE_DRAW);
+}
+
+static void progress_update_proc(Layer* layer, GContext* ctx) {
+    PROFILE_BEGIN(t);
+    GRect bounds = layer_get_bounds(layer);
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    graphics_draw_arc(ctx, bounds, GOvalScaleModeFitCircle, 0, TRIG_MAX_ANGLE);
+    if(s_wanted.progressArc){
+        graphics_fill_radial(ctx, bounds, GOvalScaleModeFitCircle, PROGRESS_RING_PX, 0,
+                             s_wanted.progressArc*TRIG_MAX_ANGLE/PROGRESS_FILL_ARCS);
+    }
+    PROFILE_END(t, PROFILE_DRAW);
+}
+
+// Only a pixel or an arc more or less of fill marks the layer dirty, most minutes leave both alone
+static void updateGauge(void) {
+    layer_mark_dirty(s_gauge_layer);
+    s_layer_updates++;
+}
+
+static void updateProgress(void) {
+    layer_mark_dirty(s_progress_layer);
+    s_layer_updates++;
+}
+
+static void updateSteps(void){
+    snprintf(buffer, 7, "%.5d", (int) (s_wanted.steps));
+    text_layer_set_text(s_steps_layer, buffer);
+    s_layer_updates++;
+}
+
+static void updateInactive(void){
+    snprintf(bufferActive, 5, "-%3d", s_wanted.inactive);
+    text_layer_set_text(s_active_layer, bufferActive);
+    s_layer_updates++;
+}
+
+static void updateGoal(void){
+    if(s_wanted.workout){
+        snprintf(bufferGoal, 8, "%d:%.2d", s_wanted.pace/60 % 100, s_wanted.pace%60);
+        text_layer_set_text(s_goal_layer, bufferGoal);
+        s_layer_updates++;
+        return;
+    }
+    snprintf(bufferGoal, 8, "%2d.%.2dK", (int)(s_wanted.goal/1000),(int)(s_wanted.goal%1000)/10);
+    text_layer_set_text(s_goal_layer, bufferGoal);
+    s_layer_updates++;
+}
+
+static void updatePerformance(void){
+    bitmap_layer_set_bitmap(s_performance_layer, s_perf_bitmaps[s_wanted.smiley]);
+    s_layer_updates++;
+}
+
+static void updateBattery(void){
+    if (s_wanted.charging) {
+        snprintf(bufferBattery, sizeof(bufferBattery), "+%d%%", s_wanted.battery);
+    } else {
+        snprintf(bufferBattery, sizeof(bufferBattery), "%d%%", s_wanted.battery);
+    }
+    text_layer_set_text(s_battery_layer, bufferBattery);
+    s_layer_updates++;
+}
+
+static void updateTime(void){
+    if(clock_is_24h_style() == true) {
+        strftime(bufferTime, sizeof("00:00"), "%H:%M", &s_time);
+    } else {
+        strftime(bufferTime, sizeof("00:00"), "%I:%M", &s_time);
+    }
+    text_layer_set_text(s_time_layer, bufferTime);
+    s_layer_updates++;
+}
+
+static void updateDate(void){
+    if(s_wanted.workout){
+        snprintf(bufferDate, 8, "%d/m", s_wanted.cadence % 1000);
+        text_layer_set_text(s_date_layer, bufferDate);
+        s_layer_updates++;
+        return;
+    }
+    strftime(bufferDate, 7, "%a %d", &s_time);
+    text_layer_set_text(s_date_layer, bufferDate);
+    s_layer_updates++;
+}
+
+static void render(void) {
+    PROFILE_BEGIN(t);
+    if(s_wanted.steps != s_shown.steps){
+        updateSteps();
+    }
+    if(s_wanted.inactive != s_shown.inactive){
+        updateInactive();
+    }
+    if(s_wanted.gaugePx != s_shown.gaugePx){
+        updateGauge();
+    }
+    if(s_wanted.progressArc != s_shown.progressArc){
+        updateProgress();
+    }
+    bool workout = s_wanted.workout != s_shown.workout;
+    if(s_wanted.goal != s_shown.goal || workout || (s_wanted.workout && s_wanted.pace != s_shown.pace)){
+        updateGoal();
+    }
+    if(s_wanted.smiley != s_shown.smiley){
+        updatePerformance();
+    }
+    if(s_wanted.battery != s_shown.battery || s_wanted.charging != s_shown.charging){
+        updateBattery();
+    }
+    if(s_wanted.hour != s_shown.hour || s_wanted.minute != s_shown.minute){
+        updateTime();
+    }
+    if(s_wanted.yday != s_shown.yday || workout || (s_wanted.workout && s_wanted.cadence != s_shown.cadence)){
+        updateDate();
+    }
+    s_shown = s_wanted;
+    s_renders++;
+    time_ms(&s_last_render_s, &s_last_render_ms);
+    PROFILE_END(t, PROFILE_RENDER);
+}
+
+static void render_timer_callback(void* data) {
+    s_render_timer = NULL;
+    render();
+}
+
+static void schedule_render(void) {
+    if(!s_loaded || s_render_timer){
+        return;
+    }
+    time_t now_s;
+    uint16_t now_ms;
+    time_ms(&now_s, &now_ms);
+    int32_t since = (int32_t) (now_s - s_last_render_s)*1000 + now_ms - s_last_render_ms;
+    if(since >= RENDER_INTERVAL_MS || since < 0){
+        render();
+    }else{
+        s_render_timer = app_timer_register(RENDER_INTERVAL_MS - since, render_timer_callback, NULL);
+    }
+}
+
+void face_set_time(const struct tm* tick_time) {
+    s_time = *tick_time;
+    if(s_wanted.hour == tick_time->tm_hour && s_wanted.minute == tick_time->tm_min
+            && s_wanted.yday == tick_time->tm_yday){
+        s_unchanged++;
+        return;
+    }
+    s_wanted.hour = tick_time->tm_hour;
+    s_wanted.minute = tick_time->tm_min;
+    s_wanted.yday = tick_time->tm_yday;
+    schedule_render();
+}
+
+static uint8_t gauge_px(int segmentsInactive) {
+    if(segmentsInactive >= GAUGE_FULL_MINUTES){
+        return GAUGE_FILL_PX;
+    }
+    return segmentsInactive > 0 ? segmentsInactive*GAUGE_FILL_PX/GAUGE_FULL_MINUTES : 0;
+}
+
+static uint8_t progress_arc(uint32_t steps, uint32_t goal) {
+    if(goal == 0 || steps >= goal){
+        return PROGRESS_FILL_ARCS;
+    }
+    return steps*PROGRESS_FILL_ARCS/goal;
+}
+
+void face_set_steps(uint32_t totalSteps, int segmentsInactive) {
+    if(s_wanted.steps == totalSteps && s_wanted.inactive == segmentsInactive){
+        s_unchanged++;
+        return;
+    }
+    s_wanted.steps = totalSteps;
+    s_wanted.inactive = segmentsInactive;
+    s_wanted.gaugePx = gauge_px(segmentsInactive);
+    s_wanted.progressArc = progress_arc(totalSteps, s_wanted.goal);
+    schedule_render();
+}
+
+void face_set_goal(uint32_t dailyGoal, int daysYes, int daysNo) {
+    int daysT = daysYes+daysNo;
+    int prcnt = daysT == 0 ? 50 : daysYes*100/daysT;
+    int8_t smiley = prcnt < 30 ? 2 : (prcnt > 50 ? 0 : 1);
+    if(s_wanted.goal == dailyGoal && s_wanted.smiley == smiley){
+        s_unchanged++;
+        return;
+    }
+    s_wanted.goal = dailyGoal;
+    s_wanted.smiley = smiley;
+    s_wanted.progressArc = progress_arc(s_wanted.steps, dailyGoal);
+    schedule_render();
+}
+
+void face_set_workout(bool running, uint16_t cadence, uint16_t pace) {
+    if(s_wanted.workout == running && s_wanted.cadence == cadence && s_wanted.pace == pace){
+        s_unchanged++;
+        return;
+    }
+    s_wanted.workout = running;
+    s_wanted.cadence = cadence;
+    s_wanted.pace = pace;
+    schedule_render();
+}
+
+void face_set_battery(BatteryChargeState charge_state) {
+    if(s_wanted.battery == charge_state.charge_percent && s_wanted.charging == charge_state.is_charging){
+        s_unchanged++;
+        return;
+    }
+    s_wanted.battery = charge_state.charge_percent;
+    s_wanted.charging = charge_state.is_charging;
+    schedule_render();
+}
+
+void face_log_stats(void) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "face: %d renders, %d layer updates, %d unchanged values skipped",
+            (int) s_renders, (int) s_layer_updates, (int) s_unchanged);
+    s_renders = 0;
+    s_layer_updates = 0;
+    s_unchanged = 0;
+}
+
+static TextLayer* create_text_layer(Window* window, GRect frame, const char* font, GTextAlignment alignment) {
+    TextLayer* layer = text_layer_create(frame);
+    text_layer_set_background_color(layer, GColorClear);
+    text_layer_set_text_color(layer, GColorBlack);
+    text_layer_set_font(layer, fonts_get_system_font(font));
+    text_layer_set_text_alignment(layer, alignment);
+    layer_add_child(window_get_root_layer(window), text_layer_get_layer(layer));
+    return layer;
+}
+
+void face_load(Window* window) {
+    time_t start_s = 0;
+    uint16_t start_ms = 0;
+    size_t heap_before = 0;
+    if (DEBUG) {
+        time_ms(&start_s, &start_ms);
+        heap_before = heap_bytes_used();
+    }
+
+    // Create GBitmap, then set to created BitmapLayer
+    s_background_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BG02);
+    s_background_layer = bitmap_layer_create(GRect(0, 0, 144, 168));
+    bitmap_layer_set_bitmap(s_background_layer, s_background_bitmap);
+    layer_add_child(window_get_root_layer(window), bitmap_layer_get_layer(s_background_layer));
+
+    s_atlas_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_ATLAS);
+
+    s_gauge_layer = layer_create(GAUGE_FRAME);
+    layer_set_update_proc(s_gauge_layer, gauge_update_proc);
+    layer_add_child(window_get_root_layer(window), s_gauge_layer);
+
+    s_progress_layer = layer_create(PROGRESS_FRAME);
+    layer_set_update_proc(s_progress_layer, progress_update_proc);
+    layer_add_child(window_get_root_layer(window), s_progress_layer);
+
+    // Performance
+    s_performance_layer = bitmap_layer_create(GRect(9, 60, 20, 20));
+    for(int i=0;i<3;i++){
+        s_perf_bitmaps[i] = gbitmap_create_as_sub_bitmap(s_atlas_bitmap, ATLAS_SMILEY(i));
+    }
+    layer_add_child(window_get_root_layer(window), bitmap_layer_get_layer(s_performance_layer));
+
+    s_steps_layer = create_text_layer(window, GRect(0, 34, 104, 30), FONT_KEY_GOTHIC_28_BOLD, GTextAlignmentRight);
+    s_active_layer = create_text_layer(window, GRect(107, 36, 33, 30), FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentLeft);
+    s_goal_layer = create_text_layer(window, GRect(5, 36, 44, 30), FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentLeft);
+    s_battery_layer = create_text_layer(window, GRect(104, 25, 34, 18), FONT_KEY_GOTHIC_14_BOLD, GTextAlignmentRight);
+    s_date_layer = create_text_layer(window, GRect(62, 66, 72, 24), FONT_KEY_GOTHIC_24_BOLD, GTextAlignmentRight);
+
+    // Time uses the custom font
+    //s_time_layer = text_layer_create(GRect(5, 99, 132, 38)); // for Pixel_LCD_7
+    s_time_layer = text_layer_create(GRect(7, 75, 132, 60));
+    text_layer_set_background_color(s_time_layer, GColorClear);
+    text_layer_set_text_color(s_time_layer, GColorBlack);
+    s_time_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_LCD_BOLD_60));
+    text_layer_set_font(s_time_layer, s_time_font);
+    text_layer_set_text_alignment(s_time_layer, GTextAlignmentRight);
+    layer_add_child(window_get_root_layer(window), text_layer_get_layer(s_time_layer));
+
+    // Nothing is shown yet, make every field differ from what is wanted
+    memset(&s_shown, 0xFF, sizeof(s_shown));
+    s_loaded = true;
+    render();
+
+    if (DEBUG) {
+        time_t end_s;
+        uint16_t end_ms;
+        time_ms(&end_s, &end_ms);
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "face_load: %d ms, heap +%d bytes",
+                (int) ((end_s - start_s)*1000 + end_ms - start_ms), (int) (heap_bytes_used() - heap_before));
+    }
+}
+
+void face_unload(void) {
+    s_loaded = false;
+    if(s_render_timer){
+        app_timer_cancel(s_render_timer);
+        s_render_timer = NULL;
+    }
+
+    gbitmap_destroy(s_background_bitmap);
+    for(int i=0;i<3;i++){
+        gbitmap_destroy(s_perf_bitmaps[i]);
+    }
+    gbitmap_destroy(s_atlas_bitmap);
+
+    bitmap_layer_destroy(s_background_layer);
+    layer_destroy(s_gauge_layer);
+    layer_destroy(s_progress_layer);
+    bitmap_layer_destroy(s_performance_layer);
+
+    text_layer_destroy(s_time_layer);
+    text_layer_destroy(s_steps_layer);
+    text_layer_destroy(s_active_layer);
+    text_layer_destroy(s_battery_layer);
+    text_layer_destroy(s_date_layer);
+    text_layer_destroy(s_goal_layer);
+    fonts_unload_custom_font(s_time_font);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <pebble.h>
+
+// The watchface layers together with a copy of what they show. Setters only store the new
+// value, a render formats and updates just the fields that really changed, and renders are
+// coalesced to at most one a second however often the worker sends steps.
+
+void face_load(Window* window);
+void face_unload(void);
+
+void face_set_time(const struct tm* tick_time);
+void face_set_steps(uint32_t totalSteps, int segmentsInactive);
+void face_set_goal(uint32_t dailyGoal, int daysYes, int daysNo);
+void face_set_battery(BatteryChargeState charge_state);
+
+// Running: cadence (spm) and pace (s/km) instead of the date and the goal, until running is false
+void face_set_workout(bool running, uint16_t cadence, uint16_t pace);
+
+// Logs and resets the redraw counters
+void face_log_stats(void);
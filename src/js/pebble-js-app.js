@@ -0,0 +1,116 @@
+// Phone side of the history sync, the format and the protocol are in src/core/sync.h.
+// Keeps the minutes as runs [start, length, level] in localStorage, a month of them at most,
+// and where it got to, so the next sync asks only for what is new. Minutes the watch no longer
+// had when it was asked for them are kept as gaps [start, length].
+
+var WINDOW = 4;             // SYNC_WINDOW
+var ACK_IDLE_MS = 2000;     // acknowledges a part window when nothing more comes
+var KEEP_MINUTES = 31*24*60;
+
+var from = 0;
+var has = parseInt(localStorage.getItem('syncHas') || '0', 10);
+var runs = JSON.parse(localStorage.getItem('syncRuns') || '[]');
+var gaps = JSON.parse(localStorage.getItem('syncGaps') || '[]');
+var received = 0;
+var started = false;        // a chunk of this request arrived
+var ackTimer = null;
+
+function readVarint(data, pos) {
+  var value = 0;
+  var scale = 1;
+  for (var i = 0; i < 5 && pos.at < data.length; i++) {
+    var b = data[pos.at++];
+    value += (b & 0x7F) * scale;
+    if (!(b & 0x80)) {
+      return value;
+    }
+    scale *= 128;
+  }
+  return -1;
+}
+
+function decode(data) {
+  var pos = { at: 0 };
+  var start = readVarint(data, pos);
+  if (start < 0) {
+    return;
+  }
+  var minute = from + start;
+  if (minute > has) {
+    if (started) {
+      return;     // something before it got lost, it comes again after the rewind
+    }
+    // The watch starts at the oldest minute it kept, what was before is gone
+    if (has) {
+      gaps.push([has, minute - has]);
+    }
+    has = minute;
+  }
+  started = true;
+  while (pos.at < data.length) {
+    var v = readVarint(data, pos);
+    if (v < 4) {
+      return;
+    }
+    var length = Math.floor(v / 4);
+    if (minute + length > has) {
+      var skip = Math.max(0, has - minute);
+      runs.push([minute + skip, length - skip, v & 3]);
+    }
+    minute += length;
+  }
+  if (minute > has) {
+    has = minute;
+  }
+}
+
+function save() {
+  while (runs.length && runs[0][0] + runs[0][1] < has - KEEP_MINUTES) {
+    runs.shift();
+  }
+  while (gaps.length && gaps[0][0] + gaps[0][1] < has - KEEP_MINUTES) {
+    gaps.shift();
+  }
+  localStorage.setItem('syncRuns', JSON.stringify(runs));
+  localStorage.setItem('syncGaps', JSON.stringify(gaps));
+  localStorage.setItem('syncHas', String(has));
+}
+
+function ack() {
+  if (ackTimer) {
+    clearTimeout(ackTimer);
+    ackTimer = null;
+  }
+  received = 0;
+  save();
+  Pebble.sendAppMessage({ 'SYNC_ACK': has });
+}
+
+function request() {
+  from = has;
+  received = 0;
+  started = false;
+  Pebble.sendAppMessage({ 'SYNC_FROM': from });
+}
+
+Pebble.addEventListener('ready', function() {
+  request();
+});
+
+Pebble.addEventListener('appmessage', function(e) {
+  var p = e.payload;
+  if (p.SYNC_DATA !== undefined) {
+    decode(p.SYNC_DATA);
+    if (++received >= WINDOW) {
+      ack();
+    } else {
+      if (ackTimer) {
+        clearTimeout(ackTimer);
+      }
+      ackTimer = setTimeout(ack, ACK_IDLE_MS);
+    }
+  } else if (p.SYNC_END !== undefined) {
+    ack();
+    console.log('sync: ' + runs.length + ' runs, up to minute ' + has);
+  }
+});
@@ -0,0 +1,163 @@
+// Microbenchmark of the magnitude kernel against the code it replaced.
+//
+//   cc -O2 -DHOST_BUILD -Isrc -o bench tools/bench.c src/core/magnitude.c src/core/ratio_detector.c
+//   ./bench [trace]
+//
+// First checks magnitude_isqrt() against the bit by bit square root for every squared
+// magnitude up to MAGNITUDE_MAG2_MAX, which covers the whole +-4 g range, then times one
+// pass over 10-sample batches with each: the old loop (bit by bit root, min/max by branches),
+// the new batch kernel and, for scale, the float my_sqrt() the very first detector used.
+// The batches come from the trace (raw int16 x,y,z like replay takes) or a synthetic walk.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/platform.h"
+#include "core/magnitude.h"
+#include "core/ratio_detector.h"
+
+#define BATCH 10
+#define ROUNDS 20
+
+// The square root detector_pipeline.h used before
+static uint32_t isqrt_bitwise(uint32_t num) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while(bit > num){
+        bit >>= 2;
+    }
+    while(bit != 0){
+        if(num >= root + bit){
+            num -= root + bit;
+            root = (root >> 1) + bit;
+        }else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    if(num > root){
+        root++;
+    }
+    return root;
+}
+
+static void old_batch(const AccelData* data, uint32_t n, uint32_t* ev, MagnitudeSummary* out) {
+    out->sum = 0;
+    out->min = UINT32_MAX;
+    out->max = 0;
+    for(uint32_t i=0;i<n;i++){
+        int32_t x = data[i].x;
+        int32_t y = data[i].y;
+        int32_t z = data[i].z;
+        uint32_t mag2 = (uint32_t) (x*x + y*y + z*z);
+        if(mag2 > MAGNITUDE_MAG2_MAX){
+            mag2 = MAGNITUDE_MAG2_MAX;
+        }
+        ev[i] = isqrt_bitwise(mag2 << (2*MAGNITUDE_SHIFT));
+        out->sum += ev[i];
+        if(ev[i] < out->min) out->min = ev[i];
+        if(ev[i] > out->max) out->max = ev[i];
+    }
+}
+
+static void float_batch(const AccelData* data, uint32_t n, uint32_t* ev, MagnitudeSummary* out) {
+    out->sum = 0;
+    out->min = UINT32_MAX;
+    out->max = 0;
+    for(uint32_t i=0;i<n;i++){
+        ev[i] = (uint32_t) my_sqrt(data[i].x*data[i].x + data[i].y*data[i].y + data[i].z*data[i].z);
+        out->sum += ev[i];
+        if(ev[i] < out->min) out->min = ev[i];
+        if(ev[i] > out->max) out->max = ev[i];
+    }
+}
+
+typedef void (*BatchFn)(const AccelData*, uint32_t, uint32_t*, MagnitudeSummary*);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double time_batches(BatchFn fn, const AccelData* data, size_t count, uint32_t* check) {
+    uint32_t ev[BATCH];
+    MagnitudeSummary s;
+    uint32_t acc = 0;
+    double t0 = now_seconds();
+    for(int r=0;r<ROUNDS;r++){
+        for(size_t i=0;i+BATCH<=count;i+=BATCH){
+            fn(&data[i], BATCH, ev, &s);
+            acc += s.sum + s.min + s.max + ev[BATCH-1];
+        }
+    }
+    double ns = (now_seconds() - t0) * 1e9 / ((double) ROUNDS * (count / BATCH * BATCH));
+    *check = acc;
+    return ns;
+}
+
+static size_t load(const char* path, AccelData** out) {
+    size_t count = 0;
+    size_t cap = 1 << 16;
+    AccelData* data = malloc(cap * sizeof(AccelData));
+    if(path){
+        FILE* f = fopen(path, "rb");
+        int16_t v[3];
+        while(f && data && fread(v, sizeof(v), 1, f) == 1){
+            data[count].x = v[0];
+            data[count].y = v[1];
+            data[count].z = v[2];
+            if(++count == cap){
+                cap *= 2;
+                data = realloc(data, cap * sizeof(AccelData));
+            }
+        }
+        if(f){
+            fclose(f);
+        }else{
+            perror(path);
+        }
+    }else{
+        // An hour of 2 Hz walk with some noise, gravity mostly on z
+        srand(1);
+        count = 36000;
+        data = realloc(data, count * sizeof(AccelData));
+        for(size_t i=0;i<count && data;i++){
+            int swing = (int) (i % 5) * 90 - 180;
+            data[i].x = 40 + swing/2 + rand() % 41 - 20;
+            data[i].y = -120 + rand() % 41 - 20;
+            data[i].z = -980 + swing + rand() % 41 - 20;
+        }
+    }
+    *out = data;
+    return data ? count : 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t mismatches = 0;
+    for(uint32_t mag2=0;mag2<=MAGNITUDE_MAG2_MAX;mag2++){
+        uint32_t num = mag2 << (2*MAGNITUDE_SHIFT);
+        if(magnitude_isqrt(num) != isqrt_bitwise(num)){
+            if(mismatches++ < 10){
+                printf("mismatch at %u: %u, expected %u\n", num, magnitude_isqrt(num), isqrt_bitwise(num));
+            }
+        }
+    }
+    printf("checked %u squared magnitudes, %u mismatches\n", MAGNITUDE_MAG2_MAX + 1, mismatches);
+
+    AccelData* data;
+    size_t count = load(argc > 1 ? argv[1] : NULL, &data);
+    if(count < BATCH){
+        fprintf(stderr, "not enough samples\n");
+        return 2;
+    }
+    uint32_t c0, c1, c2;
+    double tOld = time_batches(old_batch, data, count, &c0);
+    double tNew = time_batches(magnitude_batch, data, count, &c1);
+    double tFloat = time_batches(float_batch, data, count, &c2);
+    printf("%zu samples x %d: bitwise %.1f ns/sample, kernel %.1f ns/sample (%.2fx), float my_sqrt %.1f ns/sample%s\n",
+           count, ROUNDS, tOld, tNew, tOld / tNew, tFloat, c0 == c1 ? "" : ", RESULTS DIFFER");
+    free(data);
+    return mismatches || c0 != c1 ? 1 : 0;
+}
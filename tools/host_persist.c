@@ -0,0 +1,119 @@
+// In-memory persistent storage for the host builds of core/, same limits as the watch:
+// 256 bytes per key. Nothing survives the process unless it is saved to a file, see
+// host_persist.h.
+
+#include "core/platform.h"
+#include "host_persist.h"
+
+#define PERSIST_KEYS 128
+#define PERSIST_DATA_MAX_LENGTH 256
+
+typedef struct {
+    uint32_t key;
+    int size;               // 0 = free
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} Entry;
+
+static Entry s_entries[PERSIST_KEYS];
+
+HostPersistStats host_persist_stats;
+
+static Entry* find(uint32_t key, bool create) {
+    Entry* free = NULL;
+    for(int i=0;i<PERSIST_KEYS;i++){
+        if(s_entries[i].size && s_entries[i].key == key){
+            return &s_entries[i];
+        }
+        if(!free && !s_entries[i].size){
+            free = &s_entries[i];
+        }
+    }
+    if(create && free){
+        free->key = key;
+        return free;
+    }
+    return NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+    return find(key, false) != NULL;
+}
+
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size) {
+    Entry* e = find(key, false);
+    if(!e){
+        return -1;
+    }
+    int size = (size_t) e->size < buffer_size ? e->size : (int) buffer_size;
+    memcpy(buffer, e->data, size);
+    return size;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+    int32_t value = 0;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int persist_delete(const uint32_t key) {
+    Entry* e = find(key, false);
+    if(!e){
+        return -1;
+    }
+    e->size = 0;
+    return 0;
+}
+
+int persist_write_data(const uint32_t key, const void* data, const size_t size) {
+    int n = size < PERSIST_DATA_MAX_LENGTH ? (int) size : PERSIST_DATA_MAX_LENGTH;
+    Entry* e = find(key, true);
+    if(!e || n == 0){
+        return -1;
+    }
+    memcpy(e->data, data, n);
+    e->size = n;
+    host_persist_stats.writes++;
+    host_persist_stats.bytes += n;
+    return n;
+}
+
+// The file is the used entries one after the other: key, size (both uint32) and the data
+int host_persist_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if(!f){
+        return -1;
+    }
+    memset(s_entries, 0, sizeof(s_entries));
+    int keys = 0;
+    uint32_t header[2];
+    while(keys < PERSIST_KEYS && fread(header, sizeof(header), 1, f) == 1){
+        Entry* e = &s_entries[keys];
+        if(header[1] == 0 || header[1] > PERSIST_DATA_MAX_LENGTH || fread(e->data, header[1], 1, f) != 1){
+            break;
+        }
+        e->key = header[0];
+        e->size = header[1];
+        keys++;
+    }
+    fclose(f);
+    return keys;
+}
+
+int host_persist_save(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(!f){
+        return -1;
+    }
+    int keys = 0;
+    for(int i=0;i<PERSIST_KEYS;i++){
+        Entry* e = &s_entries[i];
+        if(!e->size){
+            continue;
+        }
+        uint32_t header[2] = { e->key, (uint32_t) e->size };
+        fwrite(header, sizeof(header), 1, f);
+        fwrite(e->data, e->size, 1, f);
+        keys++;
+    }
+    return fclose(f) == 0 ? keys : -1;
+}
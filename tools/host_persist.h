@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/platform.h"
+
+// What went through persist_write_data() since the start
+typedef struct {
+    uint32_t writes;
+    uint64_t bytes;
+} HostPersistStats;
+
+extern HostPersistStats host_persist_stats;
+
+// Replace the keys with the ones saved in the file, and write them out. Both return the number
+// of keys, -1 if the file can't be opened.
+int host_persist_load(const char* path);
+int host_persist_save(const char* path);
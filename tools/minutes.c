@@ -0,0 +1,215 @@
+// Runs made up minutes through activity_minute(), the same reducer the worker calls on the tick.
+//
+//   cc -O2 -DHOST_BUILD -Isrc -o minutes tools/minutes.c tools/host_persist.c src/core/*.c
+//   ./minutes [-d days] [-s seed] [-f]
+//
+// Starts a few weeks before New Year in a zone with DST (TZ from the environment, a CET/CEST
+// rule if there is none) and feeds `days` days of minutes with a plausible day in them: asleep
+// at night, sitting most of the day, a walk now and then. -f fuzzes the clock on top of that:
+// the same minute twice, the clock set ahead by hours or days, set back by up to a day.
+// After every minute the state is checked against what the reducer promises (one rollover
+// per date going forward, none going back, counters in range), then the same minutes are run
+// again without the checks and timed.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/platform.h"
+#include "core/activity.h"
+
+#define SAMPLES_PER_MINUTE 600
+
+// 2025-12-01 00:00 UTC
+#define MINUTES_START 1764547200
+
+typedef struct {
+    MinuteEvent ev;
+    uint16_t steps;         // steps of the minute, added before the tick
+    bool quiet;
+} Minute;
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+static int check_day_numbers(void) {
+    for(time_t t = 0; t < (time_t) 130*365*86400; t += 86400){
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        if(activity_day_number(tm.tm_year, tm.tm_yday) != t / 86400){
+            fprintf(stderr, "activity_day_number(%d, %d) = %d, should be %ld\n", tm.tm_year, tm.tm_yday,
+                    activity_day_number(tm.tm_year, tm.tm_yday), (long) (t / 86400));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void make_minute(Minute* m, time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    m->ev = activity_event(&tm, t / 60, SAMPLES_PER_MINUTE);
+    m->quiet = tm.tm_hour < 7 || tm.tm_hour >= 23;
+    if(m->quiet){
+        m->steps = 0;
+        m->ev.suspended = rnd(4) == 0;
+    }else if(rnd(100) < 5){
+        m->steps = 60 + rnd(60);
+    }else{
+        m->steps = rnd(100) < 20 ? rnd(40) : 0;
+    }
+    m->ev.offWrist = m->ev.suspended && rnd(8) == 0;
+}
+
+static void generate(Minute* minutes, size_t count, bool fuzz) {
+    time_t t = MINUTES_START;
+    for(size_t i = 0; i < count; i++){
+        make_minute(&minutes[i], t);
+        if(fuzz){
+            uint32_t r = rnd(20000);
+            if(r < 10){
+                continue;   // the same minute again
+            }else if(r < 13){
+                t += 3600 * (1 + rnd(72));
+            }else if(r < 16){
+                t -= 3600 * (1 + rnd(24));
+            }
+        }
+        t += 60;
+    }
+}
+
+static void add_minute(ActivityState* state, const Minute* m) {
+    BatchStats stats = {
+        .samples = SAMPLES_PER_MINUTE,
+        .lowEnergy = m->quiet,
+    };
+    activity_add_batch(state, m->steps, &stats);
+}
+
+static int check(const Minute* minutes, size_t count) {
+    ActivityState state;
+    activity_init(&state);
+    uint32_t lastMinute = UINT32_MAX;
+    int today = ACTIVITY_NO_DAY;
+    uint32_t newDays = 0;
+    uint32_t expectedDays = 0;
+    uint32_t clockBack = 0;
+
+    for(size_t i = 0; i < count; i++){
+        const MinuteEvent* ev = &minutes[i].ev;
+        add_minute(&state, &minutes[i]);
+        ActivityEffects fx = activity_minute(&state, ev);
+        int day = activity_day_number(ev->year, ev->yday);
+
+        const char* err = NULL;
+        if(ev->minute == lastMinute){
+            err = fx.events ? "the same minute was processed twice" : NULL;
+        }else if(!(fx.events & ACTIVITY_MINUTE)){
+            err = "a new minute was skipped";
+        }else if(state.saved.dayNumber != day){
+            err = "dayNumber is not the date of the minute";
+        }else if(fx.minute != ev->minute - 1){
+            err = "the history gets the wrong minute";
+        }else if(!(fx.events & ACTIVITY_NEW_DAY) != !(today != ACTIVITY_NO_DAY && day > today)){
+            err = "rollover does not match the date going forward";
+        }else if(!(fx.events & ACTIVITY_CLOCK_BACK) != !(day < today)){
+            err = "clock back not reported";
+        }else if((fx.events & ACTIVITY_NEW_DAY) && (state.saved.totalSteps || state.saved.activeMinutes)){
+            err = "counters not reset at the rollover";
+        }else if(state.saved.segmentsInactive < 0 || state.saved.segmentsInactive > 120){
+            err = "segmentsInactive out of range";
+        }else if(state.saved.dailyGoal < STATS_GOAL_MIN || state.saved.dailyGoal % 10){
+            err = "bad daily goal";
+        }
+        if(err){
+            struct tm tm;
+            time_t t = (time_t) ev->minute * 60;
+            localtime_r(&t, &tm);
+            char when[32];
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M %Z", &tm);
+            fprintf(stderr, "minute %zu (%s): %s\n", i, when, err);
+            return -1;
+        }
+
+        if(ev->minute != lastMinute){
+            expectedDays += today != ACTIVITY_NO_DAY && day > today;
+            today = day;
+        }
+        lastMinute = ev->minute;
+        newDays += (fx.events & ACTIVITY_NEW_DAY) != 0;
+        clockBack += (fx.events & ACTIVITY_CLOCK_BACK) != 0;
+    }
+    if(newDays != expectedDays){
+        fprintf(stderr, "%u rollovers, should be %u\n", newDays, expectedDays);
+        return -1;
+    }
+    printf("%zu minutes, %u rollovers, %u clock changes back, goal %u, %u/%u days hit in the last 30\n",
+           count, newDays, clockBack, state.saved.dailyGoal, state.stats.hits30, stats_month_days(&state.stats));
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const Minute* minutes, size_t count) {
+    ActivityState state;
+    activity_init(&state);
+    uint32_t events = 0;
+    double t0 = now_seconds();
+    for(size_t i = 0; i < count; i++){
+        add_minute(&state, &minutes[i]);
+        events ^= activity_minute(&state, &minutes[i].ev).events;
+    }
+    double seconds = now_seconds() - t0;
+    printf("timed in %.3f ms, %.1f M minutes/s (%x)\n", seconds * 1000,
+           seconds > 0 ? count / seconds / 1e6 : 0, events);
+}
+
+int main(int argc, char** argv) {
+    uint32_t days = 400;
+    bool fuzz = false;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+            days = strtoul(argv[++i], NULL, 10);
+        }else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            s_rng = strtoul(argv[++i], NULL, 10) | 1;
+        }else if(strcmp(argv[i], "-f") == 0){
+            fuzz = true;
+        }else{
+            fprintf(stderr, "usage: %s [-d days] [-s seed] [-f]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(!getenv("TZ")){
+        setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    }
+    tzset();
+
+    if(check_day_numbers() != 0){
+        return 1;
+    }
+
+    size_t count = (size_t) days * 24 * 60;
+    Minute* minutes = malloc(count * sizeof(Minute));
+    if(!minutes){
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    generate(minutes, count, fuzz);
+    int failed = check(minutes, count);
+    if(!failed){
+        bench(minutes, count);
+    }
+    free(minutes);
+    return failed ? 1 : 0;
+}
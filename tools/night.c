@@ -0,0 +1,114 @@
+// Replays recorded nights through the sleep engine on the host.
+//
+//   cc -O2 -DHOST_BUILD -Isrc -o night tools/night.c tools/host_persist.c src/core/*.c
+//   ./night [-s HH:MM] trace...
+//
+// A trace is raw little-endian int16 x,y,z triples at 10 Hz, the format tools/replay takes,
+// starting at -s local time (22:00 if not given). It goes through the peak detector in batches of
+// 10 like on the watch, the batch stats to sleep_add_batch() and every 600 samples a minute tick
+// to sleep_minute(), with the minute counted as walking the way the history does it. The trace
+// ending before the engine scored the night scores what there is. Printed: onset, wake, asleep and
+// restless minutes, the restless periods and how many of the SLEEP_BUFFER bytes the night took.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/platform.h"
+#include "core/detector.h"
+#include "core/history.h"
+#include "core/sleep.h"
+
+#define SAMPLES_PER_MINUTE 600
+#define BATCH 10
+
+static void print_time(uint32_t minute) {
+    printf("%02u:%02u", (unsigned) (minute / 60 % 24), (unsigned) (minute % 60));
+}
+
+static int night(const char* path, uint32_t startMinute, SleepReport* report) {
+    FILE* f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return -1;
+    }
+    static SleepRecorder sleep;
+    StepDetector det;
+    sleep_init(&sleep);
+    detector_init(&det, NULL);
+
+    AccelData batch[BATCH];
+    uint32_t minute = startMinute;
+    uint32_t samples = 0;
+    uint32_t steps = 0;
+    bool scored = false;
+    // The first tick is the one of the start time, nothing recorded before it
+    scored = sleep_minute(&sleep, minute, minute / 60 % 24, false, report);
+
+    int16_t v[3*BATCH];
+    size_t n;
+    while(!scored && (n = fread(v, 3*sizeof(int16_t), BATCH, f)) > 0){
+        for(size_t i = 0; i < n; i++){
+            batch[i].x = v[3*i];
+            batch[i].y = v[3*i + 1];
+            batch[i].z = v[3*i + 2];
+        }
+        BatchStats stats;
+        steps += detector_process(&det, batch, n, &stats);
+        sleep_add_batch(&sleep, &stats);
+        samples += n;
+        if(samples >= SAMPLES_PER_MINUTE){
+            samples -= SAMPLES_PER_MINUTE;
+            minute++;
+            bool walking = history_level(steps, false) == HISTORY_ACTIVE;
+            steps = 0;
+            scored = sleep_minute(&sleep, minute, minute / 60 % 24, walking, report);
+        }
+    }
+    fclose(f);
+    if(!scored){
+        sleep_score(&sleep, report);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t start = 22*60;
+    int failed = 0;
+    int files = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            unsigned h, m;
+            if(sscanf(argv[++i], "%u:%u", &h, &m) != 2 || h > 23 || m > 59){
+                fprintf(stderr, "bad start time %s\n", argv[i]);
+                return 2;
+            }
+            start = h*60 + m;
+            continue;
+        }
+
+        SleepReport r;
+        files++;
+        if(night(argv[i], start, &r) != 0){
+            failed++;
+            continue;
+        }
+        printf("%s: recorded from ", argv[i]);
+        print_time(r.start);
+        if(r.onset){
+            printf(", onset ");
+            print_time(r.onset);
+            printf(", wake ");
+            print_time(r.wake);
+            printf(", %u min asleep, %u restless in %u periods", r.sleepMinutes, r.restlessMinutes, r.restlessPeriods);
+        }else{
+            printf(", no sleep");
+        }
+        printf(", %u of %u bytes\n", r.bytes, SLEEP_BUFFER);
+    }
+    if(files == 0){
+        fprintf(stderr, "usage: %s [-s HH:MM] trace...\n", argv[0]);
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
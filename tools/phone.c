@@ -0,0 +1,200 @@
+// Stands in for the phone side of the history sync (src/js) on the host.
+//
+//   cc -O2 -DHOST_BUILD -Isrc -o phone tools/phone.c tools/host_persist.c src/core/*.c
+//   ./phone [-d days] [-m outbox] [-l loss%] [-x messages] [-g days] [-s seed]
+//
+// Writes `days` days of made up minutes into the history through history_add(), the way the
+// worker does, then syncs them over a pretend AppMessage link of the given outbox size (bytes
+// of the whole dictionary, the chunk gets what the tuple header leaves). -l fails that share of
+// the watch's sends, the watch gets told and goes back to the last acknowledgement. -x drops
+// the connection every that many messages and the phone asks again from what it has, the way
+// the JS does when it reconnects. -g makes the phone's last sync that many days older than the
+// first minute written, a phone that was away longer than the watch keeps history: the sync
+// starts at the oldest minute kept and the phone records the gap. Every decoded minute is
+// checked against the history, and with a week or more written the minute a week back has to
+// be in it, the ring wrapped or not.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/platform.h"
+#include "core/history.h"
+#include "core/sync.h"
+
+// 2026-03-01 00:00 UTC
+#define PHONE_START_MINUTE (1772323200 / 60)
+
+// Dictionary header plus one tuple header
+#define DICT_OVERHEAD (1 + 7)
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+static void fill_history(History* history, uint32_t days) {
+    history_load(history);
+    uint32_t minute = PHONE_START_MINUTE;
+    for(uint32_t i = 0; i < days*24*60; i++, minute++){
+        uint32_t hour = (minute / 60) % 24;
+        HistoryLevel level;
+        if(hour < 7 || hour >= 23){
+            level = rnd(100) < 97 ? HISTORY_ASLEEP : HISTORY_STILL;
+        }else if(rnd(100) < 5){
+            level = HISTORY_ACTIVE;
+        }else{
+            level = rnd(100) < 15 ? HISTORY_LIGHT : HISTORY_STILL;
+        }
+        history_add(history, minute, level);
+    }
+    history_flush(history);
+}
+
+typedef struct {
+    HistoryReader truth;
+    uint32_t has;           // everything before this minute arrived
+    uint32_t gap;           // minutes the watch didn't have any more
+    uint32_t errors;
+} Phone;
+
+static void check_run(void* context, uint32_t start, uint32_t length, HistoryLevel level) {
+    Phone* phone = context;
+    for(uint32_t m = start; m < start + length; m++){
+        if(history_reader_get(&phone->truth, m) != (int) level){
+            if(phone->errors++ < 10){
+                fprintf(stderr, "minute %u: got %d, history has %d\n", m, level, history_reader_get(&phone->truth, m));
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t days = 7;
+    uint32_t outbox = 656;
+    uint32_t loss = 0;
+    uint32_t disconnect = 0;
+    uint32_t stale = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(i + 1 >= argc){
+            fprintf(stderr, "usage: %s [-d days] [-m outbox] [-l loss%%] [-x messages] [-g days] [-s seed]\n", argv[0]);
+            return 2;
+        }
+        uint32_t v = strtoul(argv[i + 1], NULL, 10);
+        if(strcmp(argv[i], "-d") == 0){
+            days = v;
+        }else if(strcmp(argv[i], "-m") == 0){
+            outbox = v;
+        }else if(strcmp(argv[i], "-l") == 0){
+            loss = v;
+        }else if(strcmp(argv[i], "-x") == 0){
+            disconnect = v;
+        }else if(strcmp(argv[i], "-g") == 0){
+            stale = v;
+        }else if(strcmp(argv[i], "-s") == 0){
+            s_rng = v | 1;
+        }else{
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+        i++;
+    }
+    if(outbox < DICT_OVERHEAD + 2*SYNC_VARINT_MAX){
+        fprintf(stderr, "outbox too small\n");
+        return 2;
+    }
+
+    History history;
+    fill_history(&history, days);
+
+    Phone phone = { .has = stale ? PHONE_START_MINUTE - stale*24*60 : 0 };
+    history_reader_open(&phone.truth, NULL);
+    if(days >= 7 && history_reader_get(&phone.truth, phone.truth.meta.headTime - 7*24*60) < 0){
+        fprintf(stderr, "the minute a week back is not in the history\n");
+        return 1;
+    }
+
+    size_t size = outbox - DICT_OVERHEAD;
+    uint8_t* buf = malloc(size);
+    SyncSession sync;
+    uint32_t from = phone.has;
+    sync_start(&sync, NULL, from);
+    uint32_t received = 0;      // chunks since the phone last acknowledged
+    bool started = false;       // a chunk of this request arrived
+    uint32_t messages = 0;
+    uint32_t failed = 0;
+    uint32_t requests = 1;
+    uint64_t bytes = 0;
+    uint32_t first = sync.next;
+
+    while(!sync_done(&sync)){
+        if(disconnect && messages && messages % disconnect == 0){
+            // Gone and back, the phone asks again from what it has
+            from = phone.has;
+            sync_start(&sync, NULL, from);
+            received = 0;
+            started = false;
+            requests++;
+            messages++;
+            continue;
+        }
+        size_t len = sync_next_chunk(&sync, buf, size);
+        bool end = len == 0 && sync.next >= sync.end;
+        if(len == 0 && !end){
+            fprintf(stderr, "stuck: window full and no acknowledgement coming\n");
+            return 1;
+        }
+        messages++;
+        if(loss && rnd(100) < loss){
+            failed++;
+            sync_rewind(&sync);
+            continue;
+        }
+        bytes += DICT_OVERHEAD + (end ? sizeof(uint32_t) : len);
+
+        if(!end){
+            // A chunk that starts past what the phone has would leave a hole, it waits for the
+            // resend. Only the first one of a request may: the watch starts at its oldest minute.
+            uint32_t start = sync_chunk_start(buf, len, from);
+            if(!started && start > phone.has){
+                if(phone.has){
+                    phone.gap += start - phone.has;
+                }
+                phone.has = start;
+            }
+            if(start <= phone.has){
+                started = true;
+                uint32_t next = sync_decode(buf, len, from, check_run, &phone);
+                if(next == 0){
+                    fprintf(stderr, "malformed chunk\n");
+                    return 1;
+                }
+                if(next > phone.has){
+                    phone.has = next;
+                }
+            }
+            if(++received < SYNC_WINDOW){
+                continue;
+            }
+        }
+        received = 0;
+        sync_ack(&sync, phone.has);
+    }
+    free(buf);
+
+    uint32_t minutes = phone.has - first;
+    printf("%u minutes (%.1f days) in %u messages of up to %u bytes, %u failed, %u requests, %u minutes gap\n",
+           minutes, minutes / 1440.0, messages, outbox, failed, requests, phone.gap);
+    printf("%llu bytes, %.1f bytes/day, %.2f bits/minute, %.1f messages/day\n",
+           (unsigned long long) bytes, bytes * 1440.0 / minutes, bytes * 8.0 / minutes,
+           messages * 1440.0 / minutes);
+    if(phone.errors){
+        fprintf(stderr, "%u minutes decoded wrong\n", phone.errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,406 @@
+// Replays recorded accelerometer traces through the step detectors on the host.
+//
+//   cc -O2 -DHOST_BUILD -Isrc -o replay tools/replay.c tools/host_persist.c src/core/*.c
+//   ./replay [-e peak|ratio|cadence|gait|run] [-a] [-p name=value]... trace...
+//   ./replay -c tools/golden.txt dir
+//
+// A trace is either a CSV file (.csv, one sample per line, the last three columns are x,y,z in mg,
+// anything that does not parse is skipped) or raw little-endian int16 x,y,z triples. Samples are
+// assumed to be 10 Hz and are fed in batches of 10, the same way accel_data_service does it.
+// -e run is the workout detector instead, its traces are WORKOUT_RATE Hz in WORKOUT_BATCH batches.
+// -a lets the SamplingScheduler pick the batch size like the worker does, the handler wakeups
+// per hour show what it saves. It also suspends the stream off the wrist and in deep sleep the
+// same way, with a jump of more than REPLAY_TAP_JERK mg between two samples standing in for the
+// tap that starts it again. Samples the detector never saw are reported separately.
+// -p overrides one DetectorParams field of the peak engine (ratioNum, ratioDen, minAverage,
+// minGap, maxGap, minRun, sleepEnergy), so thresholds can be swept without touching the code.
+//
+// -c checks the traces in dir against the expected counts in a golden file instead, see
+// tools/golden.txt, and fails if any is outside its tolerance. tools/traces.c writes the traces.
+//
+// Where the CPU allows it (Linux perf counters), the instructions retired by the engine per
+// sample are reported too, that is the number to watch for regressions. Built with -DPROFILE=1
+// it also dumps the per-batch profile of the engine, see core/profile.h.
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "core/platform.h"
+#include "core/detector.h"
+#include "core/ratio_detector.h"
+#include "core/cadence.h"
+#include "core/gait.h"
+#include "core/workout.h"
+#include "core/activity.h"
+#include "core/sampling.h"
+#include "core/profile.h"
+
+#define SAMPLE_RATE 10
+#define SAMPLES_PER_MINUTE (SAMPLE_RATE*60)
+#define REPLAY_TAP_JERK 400
+
+typedef enum {
+    ENGINE_PEAK,
+    ENGINE_RATIO,
+    ENGINE_CADENCE,
+    ENGINE_GAIT,
+    ENGINE_RUN,
+} Engine;
+
+typedef struct {
+    uint64_t samples;
+    uint32_t rate;          // of the trace, Hz
+    uint64_t processed;     // samples that went through the detector
+    uint32_t steps;
+    uint32_t sleepMinutes;
+    uint32_t wakeups;
+    double seconds;
+    uint64_t instructions;  // 0 if there are no counters
+    uint32_t gaitSamples[4];    // samples the gait engine put in each GaitState
+} ReplayResult;
+
+static int read_sample(FILE* f, bool csv, AccelData* a) {
+    if(!csv){
+        int16_t v[3];
+        if(fread(v, sizeof(v), 1, f) != 1){
+            return 0;
+        }
+        a->x = v[0];
+        a->y = v[1];
+        a->z = v[2];
+        return 1;
+    }
+    char line[256];
+    while(fgets(line, sizeof(line), f)){
+        long v[8];
+        int n = 0;
+        char* p = line;
+        while(n < 8){
+            char* end;
+            long x = strtol(p, &end, 10);
+            if(end == p){
+                break;
+            }
+            v[n++] = x;
+            p = end;
+            while(*p == ',' || *p == ' ' || *p == '\t' || *p == ';'){
+                p++;
+            }
+        }
+        if(n >= 3){
+            a->x = (int16_t) v[n-3];
+            a->y = (int16_t) v[n-2];
+            a->z = (int16_t) v[n-1];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Counts user space instructions of this thread, -1 if the kernel or the CPU has no counters
+static int open_instruction_counter(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void counter_enable(int fd, bool on) {
+#ifdef __linux__
+    if(fd >= 0){
+        ioctl(fd, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+static uint64_t counter_read(int fd) {
+    uint64_t value = 0;
+#ifdef __linux__
+    if(fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value)){
+        value = 0;
+    }
+#endif
+    return value;
+}
+
+typedef struct {
+    uint32_t quietSamples;
+    uint32_t samples;
+    bool isSleeping;
+} MinuteClock;
+
+// Same minute classification as activity_minute()
+static void add_samples(MinuteClock* clock, uint32_t samples, uint32_t quiet, ReplayResult* res) {
+    clock->quietSamples += quiet;
+    clock->samples += samples;
+    if(clock->samples >= SAMPLES_PER_MINUTE){
+        clock->isSleeping = clock->quietSamples > ACTIVITY_SLEEP_SAMPLES;
+        res->sleepMinutes += clock->isSleeping;
+        clock->quietSamples = 0;
+        clock->samples -= SAMPLES_PER_MINUTE;
+    }
+}
+
+static bool is_tap(const AccelData* a, const AccelData* b) {
+    return abs(a->x - b->x) + abs(a->y - b->y) + abs(a->z - b->z) > REPLAY_TAP_JERK;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int replay(const char* path, Engine engine, bool adaptive, const DetectorParams* params, ReplayResult* res) {
+    size_t len = strlen(path);
+    bool csv = len > 4 && strcmp(path + len - 4, ".csv") == 0;
+    FILE* f = fopen(path, csv ? "r" : "rb");
+    if(!f){
+        perror(path);
+        return -1;
+    }
+
+    // Read it all first, only the detector should be timed
+    size_t cap = 1 << 16;
+    size_t count = 0;
+    AccelData* data = malloc(cap * sizeof(AccelData));
+    while(data && read_sample(f, csv, &data[count])){
+        if(++count == cap){
+            cap *= 2;
+            data = realloc(data, cap * sizeof(AccelData));
+        }
+    }
+    fclose(f);
+    if(!data){
+        fprintf(stderr, "%s: out of memory\n", path);
+        return -1;
+    }
+
+    StepDetector peak;
+    RatioDetector ratio;
+    CadenceDetector cadence;
+    GaitDetector gait;
+    SamplingScheduler sampling;
+    detector_init(&peak, params);
+    // The defaults run the same constant-folded code as the watch
+    bool tuned = memcmp(params, &DETECTOR_DEFAULT_PARAMS, sizeof(*params)) != 0;
+    ratio_detector_init(&ratio);
+    cadence_init(&cadence);
+    gait_init(&gait);
+    sampling_init(&sampling);
+
+    memset(res, 0, sizeof(*res));
+    MinuteClock clock = { 0 };
+    int counter = open_instruction_counter();
+    double t0 = now_seconds();
+    for(size_t i = 0; ; ){
+        uint32_t batch = engine == ENGINE_RUN ? WORKOUT_BATCH : sampling.batchSize;
+        if(i + batch > count){
+            break;
+        }
+        uint32_t steps;
+        BatchStats stats;
+        PROFILE_BEGIN(t);
+        counter_enable(counter, true);
+        if(engine == ENGINE_PEAK){
+            steps = tuned ? detector_process_params(&peak, &data[i], batch, &stats)
+                          : detector_process(&peak, &data[i], batch, &stats);
+        }else if(engine == ENGINE_RATIO){
+            steps = ratio_detector_process(&ratio, &data[i], batch, &stats);
+        }else if(engine == ENGINE_CADENCE){
+            steps = cadence_process(&cadence, &data[i], batch, &stats);
+        }else if(engine == ENGINE_RUN){
+            steps = workout_detect(&peak, &data[i], batch, &stats);
+        }else{
+            steps = gait_process(&gait, &data[i], batch, &stats);
+        }
+        counter_enable(counter, false);
+        PROFILE_END(t, PROFILE_DETECTOR);
+        i += batch;
+        if(engine == ENGINE_GAIT){
+            res->gaitSamples[gait.state] += batch;
+        }
+        res->steps += steps;
+        res->wakeups++;
+        res->processed += batch;
+        // In 10 Hz samples whatever the rate
+        add_samples(&clock, stats.samples, stats.lowEnergy ? stats.samples : 0, res);
+        if(adaptive && sampling_update(&sampling, steps, &stats, clock.isSleeping) == SAMPLING_SUSPEND){
+            // Skip to the next tap, the worker counts the time in between as quiet
+            while(i < count && !is_tap(&data[i], &data[i-1])){
+                add_samples(&clock, 1, 1, res);
+                i++;
+            }
+            sampling_resume(&sampling);
+        }
+    }
+    res->seconds = now_seconds() - t0;
+    res->instructions = counter_read(counter);
+    if(counter >= 0){
+        close(counter);
+    }
+    res->samples = count;
+    res->rate = engine == ENGINE_RUN ? WORKOUT_RATE : SAMPLE_RATE;
+    free(data);
+    return 0;
+}
+
+static int set_param(DetectorParams* p, const char* arg) {
+    const char* eq = strchr(arg, '=');
+    if(!eq){
+        return -1;
+    }
+    long v = strtol(eq + 1, NULL, 10);
+    size_t n = eq - arg;
+#define PARAM(field) if(n == strlen(#field) && strncmp(arg, #field, n) == 0){ p->field = v; return 0; }
+    PARAM(ratioNum)
+    PARAM(ratioDen)
+    PARAM(minAverage)
+    PARAM(minGap)
+    PARAM(maxGap)
+    PARAM(minRun)
+    PARAM(sleepEnergy)
+#undef PARAM
+    return -1;
+}
+
+static int parse_engine(const char* name, Engine* engine) {
+    static const char* const names[] = { "peak", "ratio", "cadence", "gait", "run" };
+    for(int i = 0; i < (int) (sizeof(names)/sizeof(names[0])); i++){
+        if(strcmp(name, names[i]) == 0){
+            *engine = (Engine) i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// "-" in the golden file means the count isn't checked
+static bool within(const char* expected, const char* tolerance, uint32_t value) {
+    if(strcmp(expected, "-") == 0){
+        return true;
+    }
+    long e = strtol(expected, NULL, 10);
+    long t = strtol(tolerance, NULL, 10);
+    return labs((long) value - e) <= t;
+}
+
+// One line per check: trace engine fixed|adaptive steps tolerance sleepMinutes tolerance
+static int check(const char* golden, const char* dir) {
+    FILE* f = fopen(golden, "r");
+    if(!f){
+        perror(golden);
+        return 2;
+    }
+    char line[256];
+    int checks = 0;
+    int failed = 0;
+    while(fgets(line, sizeof(line), f)){
+        char trace[64], engineName[16], mode[16], steps[16], stepsTol[16], sleep[16], sleepTol[16];
+        if(line[0] == '#' || sscanf(line, "%63s %15s %15s %15s %15s %15s %15s", trace, engineName, mode,
+                steps, stepsTol, sleep, sleepTol) != 7){
+            continue;
+        }
+        Engine engine;
+        if(parse_engine(engineName, &engine) != 0){
+            fprintf(stderr, "%s: unknown engine %s\n", golden, engineName);
+            failed++;
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.raw", dir, trace);
+        ReplayResult res;
+        checks++;
+        if(replay(path, engine, strcmp(mode, "adaptive") == 0, &DETECTOR_DEFAULT_PARAMS, &res) != 0){
+            failed++;
+            continue;
+        }
+        bool ok = within(steps, stepsTol, res.steps) && within(sleep, sleepTol, res.sleepMinutes);
+        printf("%-4s %-14s %-8s %-8s %5u steps (%s ±%s), %4u sleep minutes (%s ±%s)\n", ok ? "ok" : "FAIL",
+               trace, engineName, mode, res.steps, steps, stepsTol, res.sleepMinutes, sleep, sleepTol);
+        failed += !ok;
+    }
+    fclose(f);
+    printf("%d of %d checks failed\n", failed, checks);
+    return failed || checks == 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    Engine engine = ENGINE_PEAK;
+    bool adaptive = false;
+    DetectorParams params = DETECTOR_DEFAULT_PARAMS;
+    int failed = 0;
+    int files = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-e") == 0 && i + 1 < argc){
+            i++;
+            if(parse_engine(argv[i], &engine) != 0){
+                fprintf(stderr, "unknown engine %s\n", argv[i]);
+                return 2;
+            }
+            continue;
+        }
+        if(strcmp(argv[i], "-c") == 0 && i + 2 < argc){
+            return check(argv[i+1], argv[i+2]);
+        }
+        if(strcmp(argv[i], "-a") == 0){
+            adaptive = true;
+            continue;
+        }
+        if(strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+            if(set_param(&params, argv[++i]) != 0){
+                fprintf(stderr, "bad parameter %s\n", argv[i]);
+                return 2;
+            }
+            continue;
+        }
+
+        ReplayResult res;
+        files++;
+        if(replay(argv[i], engine, adaptive, &params, &res) != 0){
+            failed++;
+            continue;
+        }
+        double simulated = (double) res.samples / res.rate;
+        printf("%s: %llu samples (%.0f s), %llu processed, %u steps, %u sleep minutes, %.0f wakeups/hour, "
+               "replayed in %.3f ms (%.0fx real time)\n",
+               argv[i], (unsigned long long) res.samples, simulated, (unsigned long long) res.processed,
+               res.steps, res.sleepMinutes,
+               simulated > 0 ? res.wakeups * 3600 / simulated : 0,
+               res.seconds * 1000, res.seconds > 0 ? simulated / res.seconds : 0);
+        if(engine == ENGINE_GAIT){
+            printf("  stationary %.0f s, vehicle %.0f s, walking %.0f s, running %.0f s\n",
+                   res.gaitSamples[GAIT_STATIONARY] / (double) SAMPLE_RATE, res.gaitSamples[GAIT_VEHICLE] / (double) SAMPLE_RATE,
+                   res.gaitSamples[GAIT_WALKING] / (double) SAMPLE_RATE, res.gaitSamples[GAIT_RUNNING] / (double) SAMPLE_RATE);
+        }
+        if(res.instructions){
+            printf("  %.1f instructions/sample\n", (double) res.instructions / res.samples);
+        }else{
+            printf("  instructions/sample: no perf counters here\n");
+        }
+        fflush(stdout);
+        profile_dump();
+    }
+    if(files == 0){
+        fprintf(stderr, "usage: %s [-e peak|ratio|cadence|gait|run] [-a] [-p name=value]... trace...\n"
+                        "       %s -c golden dir\n", argv[0], argv[0]);
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
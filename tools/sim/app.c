@@ -0,0 +1,4 @@
+// The watchface, unmodified, with its main() renamed so that it can share a process with the worker
+#define main sim_app_main
+int sim_app_main(void);
+#include "main.c"
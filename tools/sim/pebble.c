@@ -0,0 +1,912 @@
+// The Pebble API of tools/sim/pebble.h on a virtual clock, see sim.h for the loop around it.
+// Layers keep what was set on them and a dirty flag, nothing is rasterized: a redraw runs the
+// update procs of the dirty layers against a context that ignores the drawing. Heap use is
+// counted for what the API allocates, layers and bitmaps with their pixels, the way
+// heap_bytes_used() would see it. Custom fonts are not counted, their size is up to the SDK.
+
+#include <stdarg.h>
+
+#include "sim.h"
+
+#define MESSAGE_QUEUE 64
+#define MESSAGE_TYPES 16
+#define ACCEL_BATCH_MAX 100
+#define OUTBOX_MAXIMUM 656
+
+SimStats sim_stats;
+
+struct Layer {
+    GRect frame;
+    LayerUpdateProc update;
+    bool dirty;
+    Layer* prev;            // every live layer, for the redraws
+    Layer* next;
+};
+
+struct TextLayer {
+    Layer layer;
+    const char* text;
+};
+
+struct BitmapLayer {
+    Layer layer;
+    const GBitmap* bitmap;
+};
+
+struct GBitmap {
+    GRect bounds;
+    uint8_t* pixels;        // NULL for a sub-bitmap, it points into its base
+};
+
+struct Window {
+    Layer root;
+    WindowHandlers handlers;
+    bool loaded;
+};
+
+struct GContext {
+    GColor stroke;
+    GColor fill;
+};
+
+struct GFontInfo {
+    const char* key;
+};
+
+struct AppTimer {
+    uint64_t due;
+    AppTimerCallback callback;
+    void* data;
+    SimSide side;
+    AppTimer* next;
+};
+
+typedef struct {
+    SimSide to;
+    uint8_t type;
+    AppWorkerMessage msg;
+} QueuedMessage;
+
+// Pixel sizes of the image resources, the heap a gbitmap_create_with_resource() takes
+static const struct {
+    uint32_t id;
+    int16_t w;
+    int16_t h;
+} IMAGES[] = {
+    { RESOURCE_ID_IMAGE_ATLAS, 18, 54 },
+    { RESOURCE_ID_IMAGE_BG02, 144, 168 },
+    { RESOURCE_ID_IMAGE_BG, 144, 168 },
+};
+
+static SimHooks s_hooks;
+static uint64_t s_now;
+static uint64_t s_end;
+static uint64_t s_nextMinute;
+static SimSide s_side = SIM_WORKER;
+
+static size_t s_heap;
+static size_t s_heapPeak;
+static Layer* s_layers;
+static Window* s_windows[4];
+static int s_windowCount;
+static struct GFontInfo s_customFont;
+static struct GFontInfo s_systemFont;
+
+static TickHandler s_tick[SIM_SIDES];
+static AppWorkerMessageHandler s_message[SIM_SIDES];
+static QueuedMessage s_queue[MESSAGE_QUEUE];
+static int s_queueHead;
+static int s_queueCount;
+static AppWorkerMessage s_last[SIM_SIDES][MESSAGE_TYPES];
+static bool s_lastValid[SIM_SIDES][MESSAGE_TYPES];
+
+static AppTimer* s_timers;
+
+static struct {
+    AccelDataHandler handler;
+    uint32_t batch;
+    uint32_t rate;
+    uint64_t last;          // when the last batch was delivered
+    uint64_t due;
+} s_accel;
+static AccelTapHandler s_tap[SIM_SIDES];
+
+static BatteryChargeState s_battery = { .charge_percent = 100 };
+static BatteryStateHandler s_batteryHandler;
+
+// Heap
+
+static void* alloc(size_t size) {
+    size_t* p = calloc(1, sizeof(size_t) + size);
+    *p = size;
+    s_heap += size;
+    if(s_heap > s_heapPeak){
+        s_heapPeak = s_heap;
+    }
+    return p + 1;
+}
+
+static void release(void* ptr) {
+    if(!ptr){
+        return;
+    }
+    size_t* p = (size_t*) ptr - 1;
+    s_heap -= *p;
+    free(p);
+}
+
+size_t heap_bytes_used(void) {
+    return s_heap;
+}
+
+size_t sim_heap_peak(void) {
+    return s_heapPeak;
+}
+
+// Handlers
+
+static struct timespec s_handlerStart;
+
+static void handler_begin(SimSide side, SimKind kind) {
+    s_side = side;
+    sim_stats.calls[side][kind]++;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &s_handlerStart);
+}
+
+static void handler_end(SimSide side, SimKind kind) {
+    struct timespec end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    sim_stats.ns[side][kind] += (end.tv_sec - s_handlerStart.tv_sec)*1000000000LL + end.tv_nsec - s_handlerStart.tv_nsec;
+}
+
+// Time
+
+time_t sim_time(time_t* tloc) {
+    time_t t = (time_t) (s_now / 1000);
+    if(tloc){
+        *tloc = t;
+    }
+    return t;
+}
+
+uint16_t time_ms(time_t* tloc, uint16_t* ms) {
+    uint16_t m = s_now % 1000;
+    if(tloc){
+        *tloc = (time_t) (s_now / 1000);
+    }
+    if(ms){
+        *ms = m;
+    }
+    return m;
+}
+
+bool clock_is_24h_style(void) {
+    return true;
+}
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...) {
+    time_t t = (time_t) (s_now / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char when[20];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+    fprintf(stderr, "%s %s:%d ", when, src_filename, src_line_number);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// Resources and graphics
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+    return (ResHandle) (uintptr_t) resource_id;
+}
+
+GFont fonts_get_system_font(const char* font_key) {
+    s_systemFont.key = font_key;
+    return &s_systemFont;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+    return &s_customFont;
+}
+
+void fonts_unload_custom_font(GFont font) {
+}
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id) {
+    for(size_t i = 0; i < sizeof(IMAGES)/sizeof(IMAGES[0]); i++){
+        if(IMAGES[i].id == resource_id){
+            GBitmap* bitmap = alloc(sizeof(GBitmap));
+            bitmap->bounds = GRect(0, 0, IMAGES[i].w, IMAGES[i].h);
+            // 1 bit per pixel, rows padded to 32 bits
+            bitmap->pixels = alloc((IMAGES[i].w + 31)/32*4*IMAGES[i].h);
+            return bitmap;
+        }
+    }
+    return NULL;
+}
+
+GBitmap* gbitmap_create_as_sub_bitmap(const GBitmap* base_bitmap, GRect sub_rect) {
+    GBitmap* bitmap = alloc(sizeof(GBitmap));
+    bitmap->bounds = sub_rect;
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap* bitmap) {
+    if(bitmap){
+        release(bitmap->pixels);
+        release(bitmap);
+    }
+}
+
+static void layer_init(Layer* layer, GRect frame) {
+    layer->frame = frame;
+    layer->dirty = true;
+    layer->next = s_layers;
+    if(s_layers){
+        s_layers->prev = layer;
+    }
+    s_layers = layer;
+}
+
+static void layer_deinit(Layer* layer) {
+    if(layer->prev){
+        layer->prev->next = layer->next;
+    }else{
+        s_layers = layer->next;
+    }
+    if(layer->next){
+        layer->next->prev = layer->prev;
+    }
+}
+
+Layer* layer_create(GRect frame) {
+    Layer* layer = alloc(sizeof(Layer));
+    layer_init(layer, frame);
+    return layer;
+}
+
+void layer_destroy(Layer* layer) {
+    if(layer){
+        layer_deinit(layer);
+        release(layer);
+    }
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc) {
+    layer->update = update_proc;
+}
+
+void layer_add_child(Layer* parent, Layer* child) {
+}
+
+void layer_mark_dirty(Layer* layer) {
+    layer->dirty = true;
+}
+
+GRect layer_get_bounds(const Layer* layer) {
+    return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+TextLayer* text_layer_create(GRect frame) {
+    TextLayer* text_layer = alloc(sizeof(TextLayer));
+    layer_init(&text_layer->layer, frame);
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer* text_layer) {
+    if(text_layer){
+        layer_deinit(&text_layer->layer);
+        release(text_layer);
+    }
+}
+
+Layer* text_layer_get_layer(TextLayer* text_layer) {
+    return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer* text_layer, const char* text) {
+    text_layer->text = text;
+    text_layer->layer.dirty = true;
+    sim_stats.textSets++;
+}
+
+void text_layer_set_background_color(TextLayer* text_layer, GColor color) {
+}
+
+void text_layer_set_text_color(TextLayer* text_layer, GColor color) {
+}
+
+void text_layer_set_font(TextLayer* text_layer, GFont font) {
+}
+
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment text_alignment) {
+}
+
+BitmapLayer* bitmap_layer_create(GRect frame) {
+    BitmapLayer* bitmap_layer = alloc(sizeof(BitmapLayer));
+    layer_init(&bitmap_layer->layer, frame);
+    return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer) {
+    if(bitmap_layer){
+        layer_deinit(&bitmap_layer->layer);
+        release(bitmap_layer);
+    }
+}
+
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer) {
+    return (Layer*) &bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap) {
+    bitmap_layer->bitmap = bitmap;
+    bitmap_layer->layer.dirty = true;
+}
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color) {
+    ctx->stroke = color;
+}
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color) {
+    ctx->fill = color;
+}
+
+void graphics_draw_pixel(GContext* ctx, GPoint point) {
+}
+
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1) {
+}
+
+void graphics_draw_rect(GContext* ctx, GRect rect) {
+}
+
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+void graphics_draw_arc(GContext* ctx, GRect rect, GOvalScaleMode scale_mode, int32_t angle_start, int32_t angle_end) {
+}
+
+void graphics_fill_radial(GContext* ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset_thickness,
+        int32_t angle_start, int32_t angle_end) {
+}
+
+// The update procs of whatever changed, once per event like the compositor after a handler
+static void redraw(void) {
+    bool dirty = false;
+    for(Layer* layer = s_layers; layer; layer = layer->next){
+        if(!layer->dirty){
+            continue;
+        }
+        dirty = true;
+        layer->dirty = false;
+        if(layer->update){
+            GContext ctx = { GColorBlack, GColorBlack };
+            handler_begin(SIM_APP, SIM_DRAW);
+            layer->update(layer, &ctx);
+            handler_end(SIM_APP, SIM_DRAW);
+        }
+    }
+    if(dirty){
+        sim_stats.frames++;
+    }
+}
+
+// Windows
+
+Window* window_create(void) {
+    Window* window = alloc(sizeof(Window));
+    layer_init(&window->root, GRect(0, 0, 144, 168));
+    return window;
+}
+
+void window_destroy(Window* window) {
+    if(window){
+        layer_deinit(&window->root);
+        release(window);
+    }
+}
+
+void window_set_window_handlers(Window* window, WindowHandlers handlers) {
+    window->handlers = handlers;
+}
+
+Layer* window_get_root_layer(const Window* window) {
+    return (Layer*) &window->root;
+}
+
+void window_stack_push(Window* window, bool animated) {
+    if(s_windowCount < (int) (sizeof(s_windows)/sizeof(s_windows[0]))){
+        s_windows[s_windowCount++] = window;
+    }
+    if(!window->loaded && window->handlers.load){
+        window->handlers.load(window);
+    }
+    window->loaded = true;
+}
+
+// The unload handler may destroy the window, it is not touched after it
+static void window_unload(Window* window) {
+    window->loaded = false;
+    if(window->handlers.unload){
+        window->handlers.unload(window);
+    }
+}
+
+bool window_stack_contains_window(Window* window) {
+    for(int i = 0; i < s_windowCount; i++){
+        if(s_windows[i] == window){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool window_stack_remove(Window* window, bool animated) {
+    for(int i = 0; i < s_windowCount; i++){
+        if(s_windows[i] == window){
+            memmove(&s_windows[i], &s_windows[i + 1], (s_windowCount - i - 1)*sizeof(s_windows[0]));
+            s_windowCount--;
+            window_unload(window);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Services
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+    s_tick[s_side] = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+    s_tick[s_side] = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+    return s_battery;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+    s_batteryHandler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+    s_batteryHandler = NULL;
+}
+
+void sim_set_battery(BatteryChargeState charge) {
+    bool changed = charge.charge_percent != s_battery.charge_percent || charge.is_charging != s_battery.is_charging
+            || charge.is_plugged != s_battery.is_plugged;
+    s_battery = charge;
+    if(changed && s_batteryHandler){
+        handler_begin(SIM_APP, SIM_BATTERY);
+        s_batteryHandler(charge);
+        handler_end(SIM_APP, SIM_BATTERY);
+    }
+}
+
+static void accel_schedule(void) {
+    s_accel.due = s_accel.last + s_accel.batch*1000/s_accel.rate;
+}
+
+void accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler) {
+    s_accel.handler = handler;
+    s_accel.batch = samples_per_update;
+    s_accel.rate = ACCEL_SAMPLING_25HZ;
+    s_accel.last = s_now;
+    accel_schedule();
+}
+
+void accel_data_service_unsubscribe(void) {
+    s_accel.handler = NULL;
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate) {
+    s_accel.rate = rate;
+    accel_schedule();
+    return 0;
+}
+
+int accel_service_set_samples_per_update(uint32_t num_samples) {
+    if(num_samples > ACCEL_BATCH_MAX){
+        return -1;
+    }
+    s_accel.batch = num_samples;
+    accel_schedule();
+    return 0;
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+    s_tap[s_side] = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+    s_tap[s_side] = NULL;
+}
+
+void vibes_enqueue_custom_pattern(VibePattern pattern) {
+    sim_stats.vibes++;
+    // Odd segments are the pauses
+    for(uint32_t i = 0; i < pattern.num_segments; i += 2){
+        sim_stats.vibeMs += pattern.durations[i];
+    }
+}
+
+void vibes_short_pulse(void) {
+    sim_stats.vibes++;
+    sim_stats.vibeMs += 100;
+}
+
+void vibes_long_pulse(void) {
+    sim_stats.vibes++;
+    sim_stats.vibeMs += 500;
+}
+
+// Keeps the list sorted by due time, timers due at the same time fire in the order they were set
+static void timer_insert(AppTimer* timer) {
+    AppTimer** p = &s_timers;
+    while(*p && (*p)->due <= timer->due){
+        p = &(*p)->next;
+    }
+    timer->next = *p;
+    *p = timer;
+}
+
+static bool timer_unlink(AppTimer* timer) {
+    for(AppTimer** p = &s_timers; *p; p = &(*p)->next){
+        if(*p == timer){
+            *p = timer->next;
+            return true;
+        }
+    }
+    return false;
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data) {
+    // Timers live in the kernel on the watch, they are not on the app heap
+    AppTimer* timer = calloc(1, sizeof(AppTimer));
+    timer->due = s_now + timeout_ms;
+    timer->callback = callback;
+    timer->data = callback_data;
+    timer->side = s_side;
+    timer_insert(timer);
+    return timer;
+}
+
+void app_timer_cancel(AppTimer* timer_handle) {
+    if(timer_unlink(timer_handle)){
+        free(timer_handle);
+    }
+}
+
+bool app_timer_reschedule(AppTimer* timer_handle, uint32_t new_timeout_ms) {
+    if(!timer_unlink(timer_handle)){
+        return false;
+    }
+    timer_handle->due = s_now + new_timeout_ms;
+    timer_insert(timer_handle);
+    return true;
+}
+
+// HealthService
+
+#if defined(PBL_HEALTH)
+
+static uint32_t s_healthSteps;
+static uint32_t s_healthYesterday;
+static time_t s_healthDay;
+static HealthActivityMask s_healthActivities;
+static HealthEventHandler s_healthHandler;
+static void* s_healthContext;
+
+HealthValue health_service_sum_today(HealthMetric metric) {
+    return metric == HealthMetricStepCount ? (HealthValue) s_healthSteps : 0;
+}
+
+// Whole days only, today and yesterday are all it keeps
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end) {
+    if(metric != HealthMetricStepCount){
+        return 0;
+    }
+    HealthValue sum = 0;
+    if(time_start < s_healthDay && time_end > s_healthDay - SECONDS_PER_DAY){
+        sum += s_healthYesterday;
+    }
+    if(time_end > s_healthDay){
+        sum += s_healthSteps;
+    }
+    return sum;
+}
+
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric, time_t time_start, time_t time_end) {
+    return metric == HealthMetricStepCount ? HealthServiceAccessibilityMaskAvailable : HealthServiceAccessibilityMaskNotSupported;
+}
+
+HealthActivityMask health_service_peek_current_activities(void) {
+    return s_healthActivities;
+}
+
+bool health_service_events_subscribe(HealthEventHandler handler, void* context) {
+    s_healthHandler = handler;
+    s_healthContext = context;
+    return true;
+}
+
+bool health_service_events_unsubscribe(void) {
+    s_healthHandler = NULL;
+    return true;
+}
+
+// mktime() is slow enough to show up in the handler times, it runs once a day
+time_t time_start_of_today(void) {
+    static time_t start = 1;
+    static time_t end = 0;
+    time_t t = (time_t) (s_now / 1000);
+    if(t < start || t >= end){
+        struct tm tm;
+        localtime_r(&t, &tm);
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        start = mktime(&tm);
+        tm.tm_mday++;
+        tm.tm_isdst = -1;
+        end = mktime(&tm);
+    }
+    return start;
+}
+
+void sim_health(uint32_t stepsToday, uint32_t activities) {
+    time_t day = time_start_of_today();
+    if(day != s_healthDay){
+        s_healthYesterday = day - s_healthDay == SECONDS_PER_DAY ? s_healthSteps : 0;
+        s_healthDay = day;
+    }
+    bool moved = stepsToday != s_healthSteps;
+    s_healthSteps = stepsToday;
+    s_healthActivities = activities;
+    if(moved && s_healthHandler){
+        handler_begin(SIM_WORKER, SIM_HEALTH);
+        s_healthHandler(HealthEventMovementUpdate, s_healthContext);
+        handler_end(SIM_WORKER, SIM_HEALTH);
+    }
+}
+
+#else
+
+void sim_health(uint32_t stepsToday, uint32_t activities) {
+}
+
+#endif
+
+// Worker
+
+bool app_worker_is_running(void) {
+    return true;
+}
+
+int app_worker_launch(void) {
+    return 0;
+}
+
+int app_worker_message_subscribe(AppWorkerMessageHandler handler) {
+    s_message[s_side] = handler;
+    return 0;
+}
+
+int app_worker_message_unsubscribe(void) {
+    s_message[s_side] = NULL;
+    return 0;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage* data) {
+    if(s_queueCount == MESSAGE_QUEUE){
+        fprintf(stderr, "worker message queue full, type %d dropped\n", type);
+        return;
+    }
+    QueuedMessage* m = &s_queue[(s_queueHead + s_queueCount++) % MESSAGE_QUEUE];
+    m->to = s_side == SIM_WORKER ? SIM_APP : SIM_WORKER;
+    m->type = type;
+    m->msg = *data;
+}
+
+const AppWorkerMessage* sim_last_message(SimSide to, uint8_t type) {
+    return type < MESSAGE_TYPES && s_lastValid[to][type] ? &s_last[to][type] : NULL;
+}
+
+// AppMessage
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+    return APP_MSG_OK;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+    return OUTBOX_MAXIMUM;
+}
+
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+}
+
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+}
+
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+}
+
+void app_message_deregister_callbacks(void) {
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator) {
+    return APP_MSG_NOT_CONNECTED;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    return APP_MSG_NOT_CONNECTED;
+}
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+    // Count byte, then key, type and length of each tuple and its data
+    uint32_t size = 1 + tuple_count*7;
+    va_list args;
+    va_start(args, tuple_count);
+    for(int i = 0; i < tuple_count; i++){
+        size += va_arg(args, uint32_t);
+    }
+    va_end(args);
+    return size;
+}
+
+int dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* data, const uint16_t size) {
+    return 0;
+}
+
+int dict_write_uint32(DictionaryIterator* iter, const uint32_t key, const uint32_t value) {
+    return 0;
+}
+
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key) {
+    return NULL;
+}
+
+// The loop
+
+void sim_init(uint64_t startMs, uint64_t endMs, const SimHooks* hooks) {
+    s_now = startMs;
+    s_end = endMs;
+    s_nextMinute = (startMs / 60000 + 1)*60000;
+    s_hooks = *hooks;
+}
+
+static void deliver_messages(void) {
+    while(s_queueCount){
+        QueuedMessage m = s_queue[s_queueHead];
+        s_queueHead = (s_queueHead + 1) % MESSAGE_QUEUE;
+        s_queueCount--;
+        if(m.type < MESSAGE_TYPES){
+            s_last[m.to][m.type] = m.msg;
+            s_lastValid[m.to][m.type] = true;
+        }
+        if(s_message[m.to]){
+            handler_begin(m.to, SIM_MESSAGE);
+            s_message[m.to](m.type, &m.msg);
+            handler_end(m.to, SIM_MESSAGE);
+        }
+    }
+}
+
+static void fire_timer(void) {
+    AppTimer* timer = s_timers;
+    s_timers = timer->next;
+    AppTimer t = *timer;
+    free(timer);
+    handler_begin(t.side, SIM_TIMER);
+    t.callback(t.data);
+    handler_end(t.side, SIM_TIMER);
+}
+
+static void minute(void) {
+    // Both sides get the tap, the worker wakes up its accelerometer and the face its stats screen
+    if(s_hooks.minute(s_now)){
+        for(int side = 0; side < SIM_SIDES; side++){
+            if(s_tap[side]){
+                handler_begin(side, SIM_TAP);
+                s_tap[side](ACCEL_AXIS_Z, 1);
+                handler_end(side, SIM_TAP);
+            }
+            deliver_messages();
+        }
+    }
+    time_t t = (time_t) (s_now / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    TimeUnits units = SECOND_UNIT | MINUTE_UNIT;
+    if(tm.tm_min == 0){
+        units |= HOUR_UNIT;
+        if(tm.tm_hour == 0){
+            units |= DAY_UNIT;
+        }
+    }
+    for(int side = 0; side < SIM_SIDES; side++){
+        if(s_tick[side]){
+            struct tm copy = tm;
+            handler_begin(side, SIM_TICK);
+            s_tick[side](&copy, units);
+            handler_end(side, SIM_TICK);
+        }
+        deliver_messages();
+    }
+}
+
+static void accel_batch(void) {
+    static AccelData data[ACCEL_BATCH_MAX];
+    uint32_t n = s_accel.batch;
+    uint64_t from = s_accel.last;
+    s_hooks.samples(from, data, n, s_accel.rate);
+    for(uint32_t i = 0; i < n; i++){
+        data[i].did_vibrate = false;
+        data[i].timestamp = from + i*1000/s_accel.rate;
+    }
+    s_accel.last = s_now;
+    accel_schedule();
+    sim_stats.samples += n;
+    handler_begin(SIM_WORKER, SIM_ACCEL);
+    s_accel.handler(data, n);
+    handler_end(SIM_WORKER, SIM_ACCEL);
+}
+
+static void loop(void) {
+    for(;;){
+        deliver_messages();
+        redraw();
+        uint64_t next = s_nextMinute;
+        if(s_timers && s_timers->due < next){
+            next = s_timers->due;
+        }
+        if(s_accel.handler && s_accel.due < next){
+            next = s_accel.due;
+        }
+        if(next >= s_end){
+            break;
+        }
+        s_now = next;
+        // At the same millisecond timers go first, then the tick, then the accelerometer
+        if(s_timers && s_timers->due == s_now){
+            fire_timer();
+        }else if(s_nextMinute == s_now){
+            minute();
+            s_nextMinute += 60000;
+        }else{
+            accel_batch();
+        }
+    }
+    s_now = s_end;
+}
+
+void app_event_loop(void) {
+    loop();
+    // Leaving the app pops its windows before deinit() runs
+    while(s_windowCount){
+        Window* window = s_windows[--s_windowCount];
+        if(window->loaded){
+            window_unload(window);
+        }
+    }
+}
+
+void worker_event_loop(void) {
+    // The face opens once the worker is up and stays on screen for the whole simulation
+    s_side = SIM_APP;
+    sim_app_main();
+    s_side = SIM_WORKER;
+}
+
+void sim_run(void) {
+    s_side = SIM_WORKER;
+    sim_worker_main();
+}
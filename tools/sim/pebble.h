@@ -0,0 +1,313 @@
+#pragma once
+
+// The part of the Pebble SDK API the watchface and the worker use, for tools/simulate.
+// tools/sim/pebble.c implements it on a virtual clock: layers only record what was set on
+// them, persistent storage is tools/host_persist.c, vibrations are counted, and the tick
+// timer, app timers, worker messages and the accelerometer are events of sim_loop().
+// Declarations follow the SDK headers, only what the app calls is here.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Everything that asks for the time gets the virtual clock
+time_t sim_time(time_t* tloc);
+#define time(tloc) sim_time(tloc)
+uint16_t time_ms(time_t* tloc, uint16_t* ms);
+#define SECONDS_PER_DAY 86400
+
+// Logging
+
+#define APP_LOG_LEVEL_ERROR 1
+#define APP_LOG_LEVEL_WARNING 50
+#define APP_LOG_LEVEL_INFO 100
+#define APP_LOG_LEVEL_DEBUG 200
+#define APP_LOG_LEVEL_DEBUG_VERBOSE 255
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...);
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// Graphics types
+
+typedef struct { int16_t x; int16_t y; } GPoint;
+typedef struct { int16_t w; int16_t h; } GSize;
+typedef struct { GPoint origin; GSize size; } GRect;
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+
+typedef enum { GColorClear = ~0, GColorBlack = 0, GColorWhite = 1 } GColor;
+typedef enum { GCornerNone = 0, GCornersAll = 0xF } GCornerMask;
+typedef enum { GOvalScaleModeFitCircle, GOvalScaleModeFillCircle } GOvalScaleMode;
+
+#define TRIG_MAX_ANGLE 0x10000
+
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+
+typedef struct Layer Layer;
+typedef struct TextLayer TextLayer;
+typedef struct BitmapLayer BitmapLayer;
+typedef struct GBitmap GBitmap;
+typedef struct GContext GContext;
+typedef struct Window Window;
+typedef struct GFontInfo* GFont;
+typedef const void* ResHandle;
+
+typedef void (*LayerUpdateProc)(Layer* layer, GContext* ctx);
+
+// Resources, what the SDK would generate from appinfo.json
+#define RESOURCE_ID_IMAGE_ATLAS 1
+#define RESOURCE_ID_IMAGE_BG02 2
+#define RESOURCE_ID_IMAGE_BG 3
+#define RESOURCE_ID_FONT_LCD_BOLD_60 4
+
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+
+ResHandle resource_get_handle(uint32_t resource_id);
+GFont fonts_get_system_font(const char* font_key);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap* gbitmap_create_as_sub_bitmap(const GBitmap* base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap* bitmap);
+
+Layer* layer_create(GRect frame);
+void layer_destroy(Layer* layer);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_mark_dirty(Layer* layer);
+GRect layer_get_bounds(const Layer* layer);
+
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer* text_layer);
+Layer* text_layer_get_layer(TextLayer* text_layer);
+void text_layer_set_text(TextLayer* text_layer, const char* text);
+void text_layer_set_background_color(TextLayer* text_layer, GColor color);
+void text_layer_set_text_color(TextLayer* text_layer, GColor color);
+void text_layer_set_font(TextLayer* text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment text_alignment);
+
+BitmapLayer* bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer);
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap);
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color);
+void graphics_context_set_fill_color(GContext* ctx, GColor color);
+void graphics_draw_pixel(GContext* ctx, GPoint point);
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1);
+void graphics_draw_rect(GContext* ctx, GRect rect);
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_arc(GContext* ctx, GRect rect, GOvalScaleMode scale_mode, int32_t angle_start, int32_t angle_end);
+void graphics_fill_radial(GContext* ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset_thickness,
+        int32_t angle_start, int32_t angle_end);
+
+// Windows
+
+typedef void (*WindowHandler)(Window* window);
+typedef struct {
+    WindowHandler load;
+    WindowHandler appear;
+    WindowHandler disappear;
+    WindowHandler unload;
+} WindowHandlers;
+
+Window* window_create(void);
+void window_destroy(Window* window);
+void window_set_window_handlers(Window* window, WindowHandlers handlers);
+Layer* window_get_root_layer(const Window* window);
+void window_stack_push(Window* window, bool animated);
+bool window_stack_remove(Window* window, bool animated);
+bool window_stack_contains_window(Window* window);
+
+void app_event_loop(void);
+void worker_event_loop(void);
+size_t heap_bytes_used(void);
+bool clock_is_24h_style(void);
+
+// Services
+
+typedef enum {
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm* tick_time, TimeUnits units_changed);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef struct {
+    uint8_t charge_percent;
+    bool is_charging;
+    bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    bool did_vibrate;
+    uint64_t timestamp;
+} AccelData;
+
+typedef enum {
+    ACCEL_SAMPLING_10HZ = 10,
+    ACCEL_SAMPLING_25HZ = 25,
+    ACCEL_SAMPLING_50HZ = 50,
+    ACCEL_SAMPLING_100HZ = 100,
+} AccelSamplingRate;
+
+typedef enum { ACCEL_AXIS_X = 0, ACCEL_AXIS_Y = 1, ACCEL_AXIS_Z = 2 } AccelAxisType;
+
+typedef void (*AccelDataHandler)(AccelData* data, uint32_t num_samples);
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+void accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler);
+void accel_data_service_unsubscribe(void);
+int accel_service_set_sampling_rate(AccelSamplingRate rate);
+int accel_service_set_samples_per_update(uint32_t num_samples);
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+
+typedef struct {
+    const uint32_t* durations;
+    uint32_t num_segments;
+} VibePattern;
+
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void* data);
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+void app_timer_cancel(AppTimer* timer_handle);
+bool app_timer_reschedule(AppTimer* timer_handle, uint32_t new_timeout_ms);
+
+// HealthService, SDK 3 on platforms that have it. Build with -DPBL_HEALTH to simulate one of
+// those, the step counts come from the simulation (sim_health()).
+
+#if defined(PBL_HEALTH)
+
+typedef int32_t HealthValue;
+
+typedef enum {
+    HealthMetricStepCount,
+    HealthMetricActiveSeconds,
+    HealthMetricWalkedDistanceMeters,
+    HealthMetricSleepSeconds,
+    HealthMetricSleepRestfulSeconds,
+    HealthMetricRestingKCalories,
+    HealthMetricActiveKCalories,
+} HealthMetric;
+
+typedef enum {
+    HealthEventSignificantUpdate = 0,
+    HealthEventMovementUpdate,
+    HealthEventSleepUpdate,
+} HealthEventType;
+
+typedef enum {
+    HealthServiceAccessibilityMaskAvailable = 1 << 0,
+    HealthServiceAccessibilityMaskNoPermission = 1 << 1,
+    HealthServiceAccessibilityMaskNotSupported = 1 << 2,
+    HealthServiceAccessibilityMaskNotAvailable = 1 << 3,
+} HealthServiceAccessibilityMask;
+
+typedef enum {
+    HealthActivityNone = 0,
+    HealthActivitySleep = 1 << 0,
+    HealthActivityRestfulSleep = 1 << 1,
+    HealthActivityWalk = 1 << 2,
+    HealthActivityRun = 1 << 3,
+} HealthActivity;
+typedef uint32_t HealthActivityMask;
+
+typedef void (*HealthEventHandler)(HealthEventType event, void* context);
+
+HealthValue health_service_sum_today(HealthMetric metric);
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end);
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric, time_t time_start, time_t time_end);
+HealthActivityMask health_service_peek_current_activities(void);
+bool health_service_events_subscribe(HealthEventHandler handler, void* context);
+bool health_service_events_unsubscribe(void);
+time_t time_start_of_today(void);
+
+#endif
+
+// Persistent storage, tools/host_persist.c
+
+bool persist_exists(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_delete(const uint32_t key);
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void* data, const size_t size);
+
+// Worker
+
+typedef struct {
+    uint16_t data0;
+    uint16_t data1;
+    uint16_t data2;
+} AppWorkerMessage;
+
+typedef void (*AppWorkerMessageHandler)(uint16_t type, AppWorkerMessage* data);
+bool app_worker_is_running(void);
+int app_worker_launch(void);
+int app_worker_message_subscribe(AppWorkerMessageHandler handler);
+int app_worker_message_unsubscribe(void);
+void app_worker_send_message(uint8_t type, AppWorkerMessage* data);
+
+// AppMessage. There is no phone in the simulation, nothing comes in and the outbox never opens.
+
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 1 << 1,
+    APP_MSG_NOT_CONNECTED = 1 << 3,
+    APP_MSG_BUSY = 1 << 10,
+} AppMessageResult;
+
+typedef struct DictionaryIterator DictionaryIterator;
+typedef struct {
+    uint32_t key;
+    uint8_t type;
+    uint16_t length;
+    union {
+        uint8_t data[0];
+        uint32_t uint32;
+    } value[];
+} Tuple;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator* iterator, void* context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator* iterator, void* context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator* iterator, AppMessageResult reason, void* context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+uint32_t app_message_outbox_size_maximum(void);
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void app_message_deregister_callbacks(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator);
+AppMessageResult app_message_outbox_send(void);
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+int dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* data, const uint16_t size);
+int dict_write_uint32(DictionaryIterator* iter, const uint32_t key, const uint32_t value);
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key);
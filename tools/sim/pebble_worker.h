@@ -0,0 +1,4 @@
+#pragma once
+
+// The worker API is a subset of the app's in the simulation, one shim serves both
+#include "pebble.h"
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pebble.h"
+
+// The simulation side of the shim: the virtual clock, the event loop and its counters.
+// sim_run() starts the worker, the worker's event loop starts the face and the face's runs
+// the events until the end time, then both shut down the way they would on the watch.
+
+typedef enum {
+    SIM_WORKER,
+    SIM_APP,
+    SIM_SIDES
+} SimSide;
+
+typedef enum {
+    SIM_ACCEL,              // accelerometer batches
+    SIM_TAP,
+    SIM_TICK,
+    SIM_MESSAGE,            // worker messages received
+    SIM_TIMER,
+    SIM_BATTERY,
+    SIM_DRAW,               // layer update procs
+    SIM_HEALTH,             // HealthService events
+    SIM_KINDS
+} SimKind;
+
+typedef struct {
+    uint32_t calls[SIM_SIDES][SIM_KINDS];
+    uint64_t ns[SIM_SIDES][SIM_KINDS];  // thread CPU time spent in the handlers
+    uint64_t samples;
+    uint32_t frames;        // screen redraws, one per event that left something dirty
+    uint32_t textSets;
+    uint32_t vibes;
+    uint32_t vibeMs;
+} SimStats;
+
+typedef struct {
+    // Accelerometer samples for n samples at rate Hz from ms on, the clock is ms since 1970
+    void (*samples)(uint64_t ms, AccelData* data, uint32_t n, uint32_t rate);
+    // Start of every minute, before the ticks. Returns true when the wearer moves enough to tap.
+    bool (*minute)(uint64_t ms);
+} SimHooks;
+
+extern SimStats sim_stats;
+
+void sim_init(uint64_t startMs, uint64_t endMs, const SimHooks* hooks);
+void sim_run(void);
+
+void sim_set_battery(BatteryChargeState charge);
+
+// What HealthService reports: steps since midnight and the HealthActivity bits. A change of
+// the steps is a movement update. Does nothing unless built with PBL_HEALTH.
+void sim_health(uint32_t stepsToday, uint32_t activities);
+
+// The last message of the type that arrived on that side, NULL if none did
+const AppWorkerMessage* sim_last_message(SimSide to, uint8_t type);
+
+size_t sim_heap_peak(void);
+
+// main() of src/main.c and worker_src/worker.c, renamed by tools/sim/app.c and worker.c
+int sim_app_main(void);
+int sim_worker_main(void);
@@ -0,0 +1,5 @@
+// The background worker, unmodified, with its main() renamed like the face's in app.c
+#define PEBBLE_WORKER
+#define main sim_worker_main
+int sim_worker_main(void);
+#include "../../worker_src/worker.c"
@@ -0,0 +1,349 @@
+// Runs the whole watchface, face and worker, through simulated days on the host.
+//
+//   cc -O2 -Itools/sim -Isrc -o simulate tools/simulate.c tools/sim/*.c tools/host_persist.c src/core/*.c
+//       src/face.c src/detail.c src/export.c worker_src/health.c -lm
+//   ./simulate [-d days] [-s seed] [-f file] [-q] [-v vibrations]
+//
+// With -DPBL_HEALTH it is a watch with HealthService: the worker takes its steps from there and
+// never starts the accelerometer. The system's count is the cadence of the walks and runs.
+//
+// src/main.c and worker_src/worker.c are built unmodified against the shim in tools/sim, which
+// runs them on a virtual clock: the minute ticks, app timers, worker messages and accelerometer
+// batches are delivered in time order as fast as the host goes. The wearer sleeps at night,
+// takes the watch off for a shower, walks to work and back, sits, and runs every other
+// evening, with the times moved around a little from day to day (-s picks another set).
+// The days start Monday 2026-03-02 in the local zone (TZ), so DST can be had with TZ set.
+// -f keeps persistent storage in a file: loaded before if it exists, saved after. The next run
+// starts on the same date again, which the worker takes as the clock set back. -q is a
+// sedentary wearer: no walks and no runs, sitting from getting up to going to bed. -v fails
+// the run when the inactivity reminders went off more than that many times a day on average.
+//
+// Per simulated day it prints the handler calls (accelerometer, ticks, worker messages, app
+// timers), the screen redraws, the persist writes, the vibrations and the CPU time spent in the
+// handlers of the worker and the face, then the averages. CPU per simulated day is the number
+// to track. The taps open the face's stats screen too: the face heap is reported as what stays
+// allocated with the face alone and as the peak with the stats screen up. CPU is thread CPU
+// time of the handlers on the host, clock_gettime around every call included (a few percent
+// of it), not what the watch's CPU would take.
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim.h"
+#include "host_persist.h"
+#include "core/worker_msg.h"
+
+#define SIM_DAYS 14
+
+// Steps per minute the system counts for a minute of walking and of running
+#define WALK_SPM 108
+#define RUN_SPM 156
+
+typedef enum {
+    WEAR_SLEEP,
+    WEAR_OFF_WRIST,
+    WEAR_SIT,
+    WEAR_WALK,
+    WEAR_RUN,
+} Wear;
+
+// A day of the wearer, minutes after midnight
+typedef struct {
+    uint16_t wake;
+    uint16_t bed;
+    uint16_t commute;       // to work, back at commute + 9 h
+    uint16_t lunch;
+    uint16_t run;           // 0 = rest day
+} DayPlan;
+
+typedef struct {
+    SimStats sim;
+    HostPersistStats persist;
+} Snapshot;
+
+static uint32_t s_rng = 1;
+static DayPlan s_plan;
+static int s_planDay = -1;     // days planned so far
+static Wear s_wear = WEAR_SIT;
+static bool s_turned;           // turned over in bed this minute
+static int16_t s_gravity[3] = { 0, 0, -1000 };
+static int s_day = -1;          // tm_yday of the day being counted
+static char s_dayLabel[16];
+static Snapshot s_dayStart;
+static Snapshot s_zero;          // before the first day
+static uint8_t s_battery = 100;
+static uint64_t s_steps;          // of the days that ended
+static uint32_t s_systemSteps;    // today, what HealthService would say
+static size_t s_residentHeap;     // face heap at the minute ticks, the stats screen is down by then
+static bool s_charging = false;
+static bool s_sedentary = false;  // -q
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+// Roughly normal, sd 1/2 of n
+static int32_t noise(int32_t n) {
+    return (int32_t) (rnd(n + 1) + rnd(n + 1)) - n;
+}
+
+static void make_plan(DayPlan* p) {
+    p->wake = 6*60 + 30 + rnd(45);
+    p->bed = 22*60 + 30 + rnd(75);
+    p->commute = p->wake + 60 + rnd(15);
+    p->lunch = 12*60 + rnd(30);
+    p->run = s_planDay % 2 ? 19*60 + rnd(30) : 0;
+}
+
+static Wear wear_at(const DayPlan* p, int m) {
+    if(m < p->wake || m >= p->bed){
+        return WEAR_SLEEP;
+    }
+    if(m < p->wake + 15){
+        return WEAR_SIT;
+    }
+    if(m < p->wake + 30){
+        return WEAR_OFF_WRIST;
+    }
+    if(s_sedentary){
+        return WEAR_SIT;
+    }
+    if((m >= p->commute && m < p->commute + 20) || (m >= p->commute + 9*60 && m < p->commute + 9*60 + 20)
+            || (m >= p->lunch && m < p->lunch + 15)){
+        return WEAR_WALK;
+    }
+    if(p->run && m >= p->run && m < p->run + 40){
+        return WEAR_RUN;
+    }
+    return WEAR_SIT;
+}
+
+static void samples(uint64_t ms, AccelData* data, uint32_t n, uint32_t rate) {
+    for(uint32_t i = 0; i < n; i++){
+        double t = (ms + (uint64_t) i*1000/rate) / 1000.0;
+        int32_t x = s_gravity[0], y = s_gravity[1], z = s_gravity[2];
+        switch(s_wear){
+            case WEAR_SLEEP:
+                x += noise(4); y += noise(4); z += noise(4);
+                break;
+            case WEAR_OFF_WRIST:
+                x += noise(1); y += noise(1); z += noise(1);
+                break;
+            case WEAR_SIT:
+                x += noise(15); y += noise(15); z += noise(25);
+                if(rnd(50) == 0){
+                    x += noise(200); z += noise(200);
+                }
+                break;
+            case WEAR_WALK:
+                z += (int32_t) (350*sin(2*M_PI*1.8*t)) + noise(30);
+                x += (int32_t) (150*sin(M_PI*1.8*t)) + noise(30);
+                break;
+            case WEAR_RUN:
+                z += (int32_t) (900*sin(2*M_PI*2.6*t)) + noise(60);
+                x += (int32_t) (300*sin(M_PI*2.6*t)) + noise(60);
+                break;
+        }
+        data[i].x = x;
+        data[i].y = y;
+        data[i].z = z;
+    }
+}
+
+static void snapshot(Snapshot* s) {
+    s->sim = sim_stats;
+    s->persist = host_persist_stats;
+}
+
+static uint64_t cpu_ns(const SimStats* s, SimSide side) {
+    uint64_t ns = 0;
+    for(int k = 0; k < SIM_KINDS; k++){
+        ns += s->ns[side][k];
+    }
+    return ns;
+}
+
+static void print_header(void) {
+    printf("%-10s %6s %6s %6s %5s %5s %6s %7s %6s %6s %5s %8s %8s\n", "day", "steps", "accel", "tap", "tick",
+           "msgs", "timers", "redraws", "texts", "writes", "vibes", "worker", "face");
+}
+
+// Counters from a to b, one line
+static void print_delta(const char* label, const Snapshot* a, const Snapshot* b, uint32_t steps, double days) {
+    const SimStats* x = &a->sim;
+    const SimStats* y = &b->sim;
+    #define D(field) ((y->field - x->field) / days)
+    uint32_t msgs = 0, timers = 0, ticks = 0;
+    for(int side = 0; side < SIM_SIDES; side++){
+        msgs += y->calls[side][SIM_MESSAGE] - x->calls[side][SIM_MESSAGE];
+        timers += y->calls[side][SIM_TIMER] - x->calls[side][SIM_TIMER];
+        ticks += y->calls[side][SIM_TICK] - x->calls[side][SIM_TICK];
+    }
+    printf("%-10s %6u %6.0f %6.0f %5.0f %5.0f %6.0f %7.0f %6.0f %6.0f %5.0f %6.2fms %6.2fms\n", label, steps,
+           D(calls[SIM_WORKER][SIM_ACCEL]), D(calls[SIM_WORKER][SIM_TAP]), ticks / days, msgs / days, timers / days,
+           D(frames), D(textSets), (b->persist.writes - a->persist.writes) / days, D(vibes),
+           (cpu_ns(y, SIM_WORKER) - cpu_ns(x, SIM_WORKER)) / days / 1e6,
+           (cpu_ns(y, SIM_APP) - cpu_ns(x, SIM_APP)) / days / 1e6);
+    #undef D
+}
+
+static uint32_t face_steps(void) {
+    const AppWorkerMessage* m = sim_last_message(SIM_APP, WORKER_MSG_STEPS);
+    return m ? m->data0 | ((uint32_t) m->data1 << 16) : 0;
+}
+
+// The counters of the day that just ended, one line
+static void end_day(void) {
+    Snapshot now;
+    snapshot(&now);
+    print_delta(s_dayLabel, &s_dayStart, &now, face_steps(), 1);
+    s_dayStart = now;
+    s_steps += face_steps();
+}
+
+static bool minute(uint64_t ms) {
+    if(heap_bytes_used() > s_residentHeap){
+        s_residentHeap = heap_bytes_used();
+    }
+    time_t t = (time_t) (ms / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    // Local midnight, DST or not
+    if(tm.tm_yday != s_day){
+        if(s_day >= 0){
+            end_day();
+        }
+        s_day = tm.tm_yday;
+        strftime(s_dayLabel, sizeof(s_dayLabel), "%a %m-%d", &tm);
+        s_planDay++;
+        make_plan(&s_plan);
+        s_systemSteps = 0;
+    }
+
+    Wear was = s_wear;
+    s_wear = wear_at(&s_plan, tm.tm_hour*60 + tm.tm_min);
+    s_turned = false;
+    if(s_wear == WEAR_SLEEP && rnd(25) == 0){
+        s_turned = true;
+        s_gravity[0] = (int16_t) noise(700);
+        s_gravity[1] = (int16_t) noise(700);
+        s_gravity[2] = -700;
+    }else if(s_wear != WEAR_SLEEP && was == WEAR_SLEEP){
+        s_gravity[0] = 0;
+        s_gravity[1] = 0;
+        s_gravity[2] = -1000;
+    }
+
+    s_systemSteps += s_wear == WEAR_WALK ? WALK_SPM : (s_wear == WEAR_RUN ? RUN_SPM : 0);
+#if defined(PBL_HEALTH)
+    static const HealthActivityMask activities[] = {
+        [WEAR_SLEEP] = HealthActivitySleep,
+        [WEAR_WALK] = HealthActivityWalk,
+        [WEAR_RUN] = HealthActivityRun,
+    };
+    sim_health(s_systemSteps, activities[s_wear]);
+#endif
+
+    // A percent every 90 minutes, on the charger at night when under 30 %
+    if(s_wear == WEAR_SLEEP && was != WEAR_SLEEP && s_battery < 30){
+        s_charging = true;
+    }
+    if(s_wear != WEAR_SLEEP || s_battery >= 100){
+        s_charging = false;
+    }
+    if(s_charging){
+        s_battery += tm.tm_min % 2 == 0;
+    }else if(t / 60 % 90 == 0 && s_battery > 0){
+        s_battery--;
+    }
+    sim_set_battery((BatteryChargeState) {
+        .charge_percent = s_battery / 10 * 10,
+        .is_charging = s_charging,
+        .is_plugged = s_charging,
+    });
+
+    return s_turned || (was != s_wear && s_wear != WEAR_SLEEP && s_wear != WEAR_OFF_WRIST);
+}
+
+int main(int argc, char** argv) {
+    int days = SIM_DAYS;
+    const char* file = NULL;
+    int maxVibes = -1;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+            days = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            s_rng = (uint32_t) strtoul(argv[++i], NULL, 10) | 1;
+        }else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc){
+            file = argv[++i];
+        }else if(strcmp(argv[i], "-q") == 0){
+            s_sedentary = true;
+        }else if(strcmp(argv[i], "-v") == 0 && i + 1 < argc){
+            maxVibes = atoi(argv[++i]);
+        }else{
+            fprintf(stderr, "usage: %s [-d days] [-s seed] [-f file] [-q] [-v vibrations]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(days <= 0){
+        fprintf(stderr, "days must be positive\n");
+        return 2;
+    }
+    if(file && host_persist_load(file) >= 0){
+        printf("persistent storage from %s\n", file);
+    }
+
+    struct tm start = { .tm_year = 2026 - 1900, .tm_mon = 2, .tm_mday = 2, .tm_isdst = -1 };
+    struct tm end = start;
+    end.tm_mday += days;
+    SimHooks hooks = { samples, minute };
+    sim_init((uint64_t) mktime(&start)*1000, (uint64_t) mktime(&end)*1000, &hooks);
+
+    print_header();
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    sim_run();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    end_day();
+
+    Snapshot total;
+    snapshot(&total);
+    print_delta("per day", &s_zero, &total, (uint32_t) (s_steps / days), days);
+
+    const SimStats* s = &total.sim;
+    printf("\n%d days, %llu samples, simulated in %.2f s (%.0fx real time)\n", days,
+           (unsigned long long) s->samples, seconds, days*86400.0 / seconds);
+    printf("persist: %u writes, %llu bytes; vibrations: %u, %u ms\n",
+           total.persist.writes, (unsigned long long) total.persist.bytes, s->vibes, s->vibeMs);
+    printf("face heap: %u bytes resident, %u bytes peak with the stats screen\n",
+           (unsigned) s_residentHeap, (unsigned) sim_heap_peak());
+    static const char* const kinds[SIM_KINDS] = { "accel", "tap", "tick", "message", "timer", "battery", "draw", "health" };
+    static const char* const sides[SIM_SIDES] = { "worker", "face" };
+    for(int side = 0; side < SIM_SIDES; side++){
+        printf("%s:", sides[side]);
+        for(int k = 0; k < SIM_KINDS; k++){
+            if(s->calls[side][k]){
+                printf(" %s %u calls %.1f us avg,", kinds[k], s->calls[side][k], s->ns[side][k] / 1e3 / s->calls[side][k]);
+            }
+        }
+        printf("\n");
+    }
+    printf("CPU per simulated day: %.2f ms (worker %.2f, face %.2f)\n",
+           (cpu_ns(s, SIM_WORKER) + cpu_ns(s, SIM_APP)) / 1e6 / days, cpu_ns(s, SIM_WORKER) / 1e6 / days,
+           cpu_ns(s, SIM_APP) / 1e6 / days);
+
+    if(file && host_persist_save(file) < 0){
+        perror(file);
+        return 1;
+    }
+    if(maxVibes >= 0 && s->vibes > (uint32_t) maxVibes*days){
+        fprintf(stderr, "%u vibrations, more than %d a day\n", s->vibes, maxVibes);
+        return 1;
+    }
+    return 0;
+}
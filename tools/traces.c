@@ -0,0 +1,206 @@
+// Writes the golden accelerometer traces tools/golden.txt is checked against.
+//
+//   cc -O2 -o traces tools/traces.c -lm
+//   ./traces dir
+//
+// The traces are synthetic, not recordings: a wrist model with a bounce per step on the gravity
+// axis and an arm swing per stride, the step rate wandering a little around its target, plus
+// sensor noise. Still wear is noise with the odd fidget, a car is random bumps, a slow sway and
+// stretches of rough road, a night is a still wrist turned over every now and then, off the
+// wrist is a watch lying flat.
+// Everything comes from one fixed seed, so the same files come out on every host and the counts
+// in golden.txt stay reproducible. The steps each trace really has (full cycles of the model)
+// are printed, that is the truth the expected counts are compared to.
+//
+// All traces are raw little-endian int16 x,y,z at 10 Hz, except the *_25hz ones at the
+// workout's WORKOUT_RATE for replay -e run.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAX_SAMPLES (3*3600*25)
+
+typedef struct {
+    int16_t (*xyz)[3];
+    size_t count;
+    uint32_t rate;
+    uint32_t steps;
+} Trace;
+
+static uint32_t s_rng = 0x2545F491;
+
+// xorshift32, the C library's rand() differs between hosts
+static double uniform(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return (s_rng >> 8) / 16777216.0;
+}
+
+static double gauss(double sigma) {
+    double u = uniform();
+    double v = uniform();
+    return sigma * sqrt(-2.0 * log(u + 1e-12)) * cos(2 * M_PI * v);
+}
+
+static void add(Trace* t, double x, double y, double z) {
+    if(t->count >= TRACE_MAX_SAMPLES){
+        return;
+    }
+    double v[3] = { x, y, z };
+    for(int i = 0; i < 3; i++){
+        double c = v[i] < -4000 ? -4000 : (v[i] > 4000 ? 4000 : v[i]);
+        t->xyz[t->count][i] = (int16_t) lround(c);
+    }
+    t->count++;
+}
+
+// Gravity along -x with the arm hanging, y is the forward swing, z sideways
+static void gait(Trace* t, double seconds, double stepHz, double bounce, double swing, double side,
+        double gx, double gy, double gz) {
+    double phase = uniform();
+    double start = phase;
+    double hz = stepHz;
+    size_t n = (size_t) (seconds * t->rate);
+    for(size_t i = 0; i < n; i++){
+        hz += (stepHz - hz) * 0.05 + gauss(0.01);
+        phase += hz / t->rate;
+        double b = bounce * sin(2 * M_PI * phase);
+        double s = swing * sin(M_PI * phase);
+        add(t, gx - b + gauss(20), gy + s + gauss(20), gz + side * sin(M_PI * phase + 1) + gauss(20));
+    }
+    t->steps += (uint32_t) floor(phase) - (uint32_t) floor(start);
+}
+
+static void walk(Trace* t, double seconds, double stepHz, double bounce, double swing) {
+    gait(t, seconds, stepHz, bounce, swing, 0, -1000, 0, 0);
+}
+
+// Sitting: the wrist on a desk or in the lap, a fidget now and then
+static void still(Trace* t, double seconds, double fidgets) {
+    size_t n = (size_t) (seconds * t->rate);
+    for(size_t i = 0; i < n; i++){
+        double m = uniform() < fidgets ? gauss(150) : 0;
+        add(t, gauss(8) + m, gauss(8) + m * 0.5, -1000 + gauss(8));
+    }
+}
+
+// In a car: random bumps and a slow sway, and every 3 minutes or so 8-16 s of rough road
+// (cobbles, road works) where the jolts come 0.3-0.8 s apart, as fast as steps but not as
+// regular. That is where the peak engine finds its false steps.
+static void drive(Trace* t, double seconds) {
+    double bump = 0;
+    double sway = uniform();
+    double rough = 0;           // samples of rough road left
+    double jolt = 0;            // samples to the next jolt on it
+    size_t n = (size_t) (seconds * t->rate);
+    for(size_t i = 0; i < n; i++){
+        if(rough > 0){
+            rough--;
+            if(--jolt <= 0){
+                bump -= 150 + uniform() * 150;
+                jolt = (0.3 + uniform() * 0.5) * t->rate;
+            }
+        }else if(uniform() < 1.0 / (180 * t->rate)){
+            rough = (8 + uniform() * 8) * t->rate;
+            jolt = 0;
+        }
+        if(uniform() < 0.06){
+            bump += gauss(220);
+        }
+        bump *= 0.55;
+        sway += 0.02 + uniform() * 0.03;
+        double s = 60 * sin(2 * M_PI * sway);
+        add(t, -300 + s * 0.3 + gauss(15), 150 + s + gauss(15), -940 + bump + gauss(15));
+    }
+}
+
+// Asleep: hardly any motion, and every 20 minutes or so turned over onto another side
+static void sleeping(Trace* t, double seconds) {
+    double g[3] = { 0, -600, -800 };
+    size_t n = (size_t) (seconds * t->rate);
+    for(size_t i = 0; i < n; i++){
+        if(uniform() < 1.0 / (20 * 60 * t->rate)){
+            g[0] = gauss(500);
+            g[1] = gauss(500);
+            g[2] = -sqrt(fmax(0, 1e6 - g[0] * g[0] - g[1] * g[1]));
+        }
+        add(t, g[0] + gauss(4), g[1] + gauss(4), g[2] + gauss(4));
+    }
+}
+
+// On the nightstand: gravity straight down and the sensor's own noise
+static void off_wrist(Trace* t, double seconds) {
+    size_t n = (size_t) (seconds * t->rate);
+    for(size_t i = 0; i < n; i++){
+        add(t, gauss(2), gauss(2), -1000 + gauss(2));
+    }
+}
+
+static int write_trace(const char* dir, const char* name, const Trace* t) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.raw", dir, name);
+    FILE* f = fopen(path, "wb");
+    if(!f){
+        perror(path);
+        return -1;
+    }
+    for(size_t i = 0; i < t->count; i++){
+        uint8_t le[6];
+        for(int k = 0; k < 3; k++){
+            le[2*k] = (uint8_t) (t->xyz[i][k] & 0xFF);
+            le[2*k + 1] = (uint8_t) ((uint16_t) t->xyz[i][k] >> 8);
+        }
+        fwrite(le, sizeof(le), 1, f);
+    }
+    if(fclose(f) != 0){
+        perror(path);
+        return -1;
+    }
+    printf("%-14s %6u steps %7.0f s\n", name, t->steps, (double) t->count / t->rate);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if(argc != 2){
+        fprintf(stderr, "usage: %s dir\n", argv[0]);
+        return 2;
+    }
+    const char* dir = argv[1];
+    Trace t = { .xyz = malloc(TRACE_MAX_SAMPLES * sizeof(*t.xyz)) };
+    if(!t.xyz){
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int failed = 0;
+#define TRACE(name, rate_, ...) do { \
+        t.count = 0; t.steps = 0; t.rate = (rate_); \
+        __VA_ARGS__; \
+        failed |= write_trace(dir, name, &t) != 0; \
+    } while(0)
+
+    TRACE("walking", 10, walk(&t, 600, 1.8, 150, 250));
+    TRACE("walk_slow", 10, walk(&t, 300, 1.4, 100, 180));
+    TRACE("running", 10, walk(&t, 300, 2.8, 550, 420));
+    TRACE("elliptical", 10, gait(&t, 600, 1.5, 15, 200, 120, -300, -200, -930));
+    TRACE("sitting", 10, still(&t, 1800, 0.01));
+    TRACE("driving", 10, drive(&t, 1800));
+    TRACE("sleeping", 10, sleeping(&t, 2 * 3600));
+    TRACE("off_wrist", 10, off_wrist(&t, 3600));
+    TRACE("errands", 10,
+        for(int k = 0; k < 6; k++){
+            walk(&t, 60 + uniform() * 140, 1.5 + uniform() * 0.5, 150, 230);
+            still(&t, 60 + uniform() * 140, 0.02);
+            if(k % 2){
+                drive(&t, 120 + uniform() * 180);
+            }
+        });
+    TRACE("running_25hz", 25, walk(&t, 300, 3.0, 550, 420));
+#undef TRACE
+
+    free(t.xyz);
+    return failed ? 1 : 0;
+}
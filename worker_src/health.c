@@ -0,0 +1,121 @@
+#include "health.h"
+
+#if defined(PBL_HEALTH)
+
+// Samples of a minute at the 10 Hz the rest of the worker counts in
+#define MINUTE_SAMPLES 600
+
+static HealthStepsHandler s_handler = NULL;
+static uint32_t s_reported = 0;     // of health_service_sum_today()
+static time_t s_day = 0;            // time_start_of_today() of s_reported, 0 = none
+static uint32_t s_minuteSteps = 0;  // handed on since the last minute tick
+
+// The steps since the last call, within the day
+static uint32_t new_steps(void) {
+    HealthValue sum = health_service_sum_today(HealthMetricStepCount);
+    uint32_t today = sum > 0 ? (uint32_t) sum : 0;
+    uint32_t steps = today > s_reported ? today - s_reported : 0;
+    s_reported = today;
+    return steps;
+}
+
+// The system's day starts over at midnight. What it counted for the day before and wasn't
+// reported yet goes to that day, the tick turns the day over only after health_minute(). The
+// new day's steps so far come with the next call.
+static uint32_t day_end_steps(time_t day) {
+    HealthValue sum = s_day ? health_service_sum(HealthMetricStepCount, s_day, day) : 0;
+    uint32_t before = sum > 0 ? (uint32_t) sum : 0;
+    uint32_t steps = before > s_reported ? before - s_reported : 0;
+    s_day = day;
+    s_reported = 0;
+    return steps;
+}
+
+static void health_handler(HealthEventType event, void* context) {
+    // Over midnight the minute tick takes it, the steps have to go before the day turns over
+    if(event != HealthEventMovementUpdate || time_start_of_today() != s_day){
+        return;
+    }
+    uint32_t steps = new_steps();
+    if(steps){
+        BatchStats stats = { 0 };
+        s_minuteSteps += steps;
+        s_handler(steps, &stats);
+    }
+}
+
+static int day_number(time_t t) {
+    struct tm* local = localtime(&t);
+    return activity_day_number(local->tm_year, local->tm_yday);
+}
+
+bool health_start(HealthStepsHandler handler, uint32_t counted, int countedDay) {
+    time_t now = time(NULL);
+    time_t today = time_start_of_today();
+    HealthServiceAccessibilityMask mask = health_service_metric_accessible(HealthMetricStepCount,
+            today, now);
+    if(!(mask & HealthServiceAccessibilityMaskAvailable)){
+        return false;
+    }
+    s_handler = handler;
+    s_minuteSteps = 0;
+    int todayNumber = day_number(today);
+    if(countedDay == todayNumber){
+        HealthValue sum = health_service_sum_today(HealthMetricStepCount);
+        uint32_t steps = sum > 0 ? (uint32_t) sum : 0;
+        s_day = today;
+        s_reported = steps < counted ? steps : counted;
+    }else if(countedDay == todayNumber - 1){
+        // Yesterday's checkpoint: as if it were just after midnight, the first tick hands over
+        // the rest of yesterday before it turns the day over, today's steps come after it
+        struct tm local = *localtime(&today);
+        local.tm_mday--;
+        s_day = mktime(&local);
+        HealthValue sum = health_service_sum(HealthMetricStepCount, s_day, today);
+        uint32_t steps = sum > 0 ? (uint32_t) sum : 0;
+        s_reported = steps < counted ? steps : counted;
+    }else{
+        // Older or none: nothing to hand over, all of today comes after the first tick
+        s_day = 0;
+        s_reported = 0;
+    }
+    return health_service_events_subscribe(health_handler, NULL);
+}
+
+void health_stop(void) {
+    health_service_events_unsubscribe();
+    s_handler = NULL;
+}
+
+void health_minute(void) {
+    time_t day = time_start_of_today();
+    uint32_t steps = day != s_day ? day_end_steps(day) : new_steps();
+    s_minuteSteps += steps;
+
+    // Quiet as the worker's own detector sees it: asleep, or a wrist that didn't take a step and
+    // isn't on a walk or a run. Sitting still is quiet there too, it doesn't run up the
+    // inactivity reminders.
+    HealthActivityMask activities = health_service_peek_current_activities();
+    bool asleep = (activities & (HealthActivitySleep | HealthActivityRestfulSleep)) != 0;
+    bool moving = s_minuteSteps || (activities & (HealthActivityWalk | HealthActivityRun));
+    BatchStats stats = {
+        .samples = MINUTE_SAMPLES,
+        .lowEnergy = asleep || !moving,
+    };
+    s_minuteSteps = 0;
+    s_handler(steps, &stats);
+}
+
+#else
+
+bool health_start(HealthStepsHandler handler, uint32_t counted, int countedDay) {
+    return false;
+}
+
+void health_stop(void) {
+}
+
+void health_minute(void) {
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pebble_worker.h>
+#include "core/detector.h"
+#include "core/activity.h"
+
+// The system's step counter as the step source, where there is one: SDK 3 on a platform with
+// PBL_HEALTH and Pebble Health turned on. The firmware counts steps and sleep anyway, at a
+// fraction of what the worker's own 10 Hz pipeline costs, so with it the worker doesn't
+// subscribe to the accelerometer at all. Everywhere else health_start() returns false and the
+// worker runs its detector as before.
+//
+// Both sources feed the same thing: steps and the BatchStats the minute bookkeeping in
+// activity_add_batch() goes by. From HealthService the stats are one whole minute per tick,
+// quiet if the system says the wearer is asleep or the minute had no steps and no walk or run
+// in it. The running mode and the sleep recorder need the raw samples and stay off with it:
+// no cadence and pace on the face during a run, and the stats screen points to Pebble Health
+// for the night. The system tracks both itself.
+
+typedef void (*HealthStepsHandler)(uint32_t steps, const BatchStats* stats);
+
+// counted is what the worker's checkpoint has for the day countedDay (a dayNumber). Steps the
+// system counted beyond that, while the worker wasn't running, come with the first minute when
+// that is today. A checkpoint of yesterday gets the rest of yesterday with the first minute and
+// today's steps come with the next, after the tick turned the day over; an older one gets all
+// of today with the next.
+bool health_start(HealthStepsHandler handler, uint32_t counted, int countedDay);
+void health_stop(void);
+
+// Minute tick, before activity_minute(). The first one of a day hands over the rest of the day
+// before.
+void health_minute(void);
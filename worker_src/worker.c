@@ -0,0 +1,300 @@
+#include <pebble_worker.h>
+#include "core/step_engine.h"
+#include "core/activity.h"
+#include "core/sampling.h"
+#include "core/history.h"
+#include "core/store.h"
+#include "core/alerts.h"
+#include "core/workout.h"
+#include "core/sleep.h"
+#include "core/worker_msg.h"
+#include "core/profile.h"
+#include "health.h"
+
+#define DEBUG false
+
+// At 10 Hz
+#define SAMPLES_PER_MINUTE 600
+
+static StepEngine s_detector;
+static ActivityState s_state;
+static SamplingScheduler s_sampling;
+static History s_history;
+static Store s_store;
+static AlertScheduler s_alerts;
+static Workout s_workout;
+static StepDetector s_runDetector;
+static SleepRecorder s_sleep;
+static AppTimer* s_alert_timer = NULL;
+static uint32_t s_wakeups = 0;
+static bool s_health = false;       // HealthService counts the steps, no accelerometer
+static bool s_suspended = false;
+static bool s_suspendedThisMinute = false;
+// What the face was sent last
+static uint32_t s_sentSteps = 0;
+static int s_sentInactive = -1;
+
+static void send_message(uint16_t type, uint16_t data0, uint16_t data1, uint16_t data2) {
+    AppWorkerMessage msg = {
+        .data0 = data0,
+        .data1 = data1,
+        .data2 = data2,
+    };
+    app_worker_send_message(type, &msg);
+}
+
+static void send_steps(void) {
+    send_message(WORKER_MSG_STEPS, s_state.saved.totalSteps & 0xFFFF, s_state.saved.totalSteps >> 16, s_state.saved.segmentsInactive);
+    s_sentSteps = s_state.saved.totalSteps;
+    s_sentInactive = s_state.saved.segmentsInactive;
+}
+
+static void send_steps_if_changed(void) {
+    if(s_state.saved.totalSteps != s_sentSteps || s_state.saved.segmentsInactive != s_sentInactive){
+        send_steps();
+    }
+}
+
+// The smiley shows the last 30 days, until there is a first day in the window the lifetime counters
+static void send_goal(void) {
+    const DailyStats* stats = &s_state.stats;
+    uint8_t days = stats_month_days(stats);
+    if(days == 0){
+        send_message(WORKER_MSG_GOAL, s_state.saved.dailyGoal/10, s_state.saved.daysYes, s_state.saved.daysNo);
+    }else{
+        send_message(WORKER_MSG_GOAL, s_state.saved.dailyGoal/10, stats->hits30, days - stats->hits30);
+    }
+}
+
+static void send_workout(void) {
+    send_message(WORKER_MSG_WORKOUT, workout_cadence(&s_workout), workout_pace(&s_workout), s_workout.active);
+}
+
+static void schedule_alert(void);
+
+static void alert_timer_callback(void* data) {
+    s_alert_timer = NULL;
+    s_alerts.due = 0;
+    // Due on the minute, when the tick may not have taken in the steps of the one that ended,
+    // or the wearer is walking already. Either way the tick decides: its schedule_alert() sets
+    // the timer again, for right then if the reminder is still due.
+    time_t now = time(NULL);
+    if(s_state.lastMinute != (uint32_t) (now / 60)
+            || s_state.saved.totalSteps - s_state.saved.oldSteps > ACTIVITY_MOVING_STEPS){
+        return;
+    }
+    // Workers cannot vibrate, the face does it if it is on screen
+    send_message(WORKER_MSG_BUZZ, alerts_fire(&s_alerts, now), 0, 0);
+    schedule_alert();
+}
+
+// Moves the reminder timer if the due time changed. Times are whole minutes, so while
+// nothing unexpected happens the due time stays the same and the timer is left alone.
+static void schedule_alert(void) {
+    time_t now = time(NULL);
+    time_t due = alerts_next(&s_alerts, &s_state, now - now % 60);
+    if(due == s_alerts.due){
+        return;
+    }
+    if(s_alert_timer){
+        app_timer_cancel(s_alert_timer);
+        s_alert_timer = NULL;
+    }
+    s_alerts.due = due;
+    if(due){
+        s_alert_timer = app_timer_register(due > now ? (due - now)*1000 : 0, alert_timer_callback, NULL);
+    }
+}
+
+// Where the steps of either source go. The face wakes up only when there is something new to show.
+static void count_steps(uint32_t steps, const BatchStats* stats) {
+    uint32_t events = activity_add_batch(&s_state, steps, stats);
+    if(events & ACTIVITY_STEPS){
+        send_steps();
+    }
+    if(events & ACTIVITY_GOAL_REACHED){
+        send_message(WORKER_MSG_GOAL_REACHED, 0, 0, 0);
+    }
+}
+
+static void accel_handler(AccelData* data, uint32_t num_samples);
+
+static void start_stream(uint16_t batchSize) {
+    accel_data_service_subscribe(batchSize, accel_handler);
+    accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
+}
+
+static void tap_handler(AccelAxisType axis, int32_t direction) {
+    accel_tap_service_unsubscribe();
+    s_suspended = false;
+    start_stream(sampling_resume(&s_sampling));
+}
+
+// Off the wrist or deep asleep, nothing to count until the watch moves again
+static void suspend_stream(void) {
+    accel_data_service_unsubscribe();
+    accel_tap_service_subscribe(tap_handler);
+    s_suspended = true;
+    s_suspendedThisMinute = true;
+}
+
+// Running: full batches at the high rate, the adaptive batches and the suspend wait
+static void start_workout(void) {
+    detector_init(&s_runDetector, NULL);
+    accel_service_set_sampling_rate(ACCEL_SAMPLING_25HZ);
+    accel_service_set_samples_per_update(WORKOUT_BATCH);
+}
+
+static void end_workout(void) {
+    accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
+    accel_service_set_samples_per_update(sampling_resume(&s_sampling));
+}
+
+static void accel_handler(AccelData* data, uint32_t num_samples) {
+    PROFILE_BEGIN(t);
+    BatchStats stats;
+    uint32_t steps;
+    bool workout = s_workout.active;
+    PROFILE_BEGIN(td);
+    if(workout){
+        steps = workout_detect(&s_runDetector, data, num_samples, &stats);
+    }else{
+        steps = step_engine_process(&s_detector, data, num_samples, &stats);
+    }
+    PROFILE_END(td, PROFILE_DETECTOR);
+    count_steps(steps, &stats);
+    sleep_add_batch(&s_sleep, &stats);
+
+    s_wakeups++;
+    uint32_t workoutEvents = workout_update(&s_workout, steps, num_samples);
+    if(workoutEvents & WORKOUT_STARTED){
+        start_workout();
+    }else if(workoutEvents & WORKOUT_ENDED){
+        end_workout();
+    }else if(!workout){
+        uint16_t batchSize = sampling_update(&s_sampling, steps, &stats, s_state.isSleeping);
+        if(batchSize == SAMPLING_SUSPEND){
+            suspend_stream();
+        }else if(batchSize){
+            accel_service_set_samples_per_update(batchSize);
+        }
+    }
+    if(workoutEvents & (WORKOUT_REPORT | WORKOUT_ENDED)){
+        send_workout();
+    }
+    PROFILE_END(t, PROFILE_ACCEL);
+}
+
+static void tick_handler(struct tm* tick_time, TimeUnits units_changed) {
+    PROFILE_BEGIN(t);
+    if(s_health){
+        health_minute();
+    }
+    MinuteEvent ev = activity_event(tick_time, time(NULL)/60, SAMPLES_PER_MINUTE);
+    ev.suspended = s_suspendedThisMinute;
+    ev.offWrist = s_suspendedThisMinute && s_sampling.state == SAMPLING_OFF_WRIST;
+    s_suspendedThisMinute = s_suspended;
+    ActivityEffects fx = activity_minute(&s_state, &ev);
+    if(!(fx.events & ACTIVITY_MINUTE)){
+        return;
+    }
+
+    if(DEBUG && tick_time->tm_min == 0){
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "accel wakeups last hour: %d", (int) s_wakeups);
+        s_wakeups = 0;
+    }
+    if(PROFILE && tick_time->tm_min == 0){
+        profile_dump();
+    }
+
+    history_add(&s_history, fx.minute, fx.level);
+    SleepReport night;
+    if(!s_health && sleep_minute(&s_sleep, ev.minute, tick_time->tm_hour, fx.level == HISTORY_ACTIVE, &night)){
+        sleep_save(&night);
+        if(DEBUG){
+            APP_LOG(APP_LOG_LEVEL_DEBUG, "night: onset %d wake %d, %d min asleep, %d restless in %d, %d bytes",
+                    (int) night.onset, (int) night.wake, night.sleepMinutes, night.restlessMinutes,
+                    night.restlessPeriods, night.bytes);
+        }
+    }
+    if(fx.events & ACTIVITY_NEW_DAY){
+        stats_save(&s_state.stats);
+        store_save(&s_store, &s_state);
+        send_goal();
+    }else if(fx.events & ACTIVITY_CLOCK_BACK){
+        store_save(&s_store, &s_state);
+    }else{
+        store_minute(&s_store, &s_state);
+    }
+    schedule_alert();
+    send_steps_if_changed();
+    PROFILE_END(t, (fx.events & ACTIVITY_NEW_DAY) ? PROFILE_NEW_DAY : PROFILE_MINUTE);
+}
+
+static void message_handler(uint16_t type, AppWorkerMessage* data) {
+    if(type == WORKER_MSG_REFRESH){
+        send_steps();
+        send_goal();
+        if(s_workout.active){
+            send_workout();
+        }
+    }else if(type == WORKER_MSG_FLUSH_HISTORY){
+        history_flush(&s_history);
+        send_message(WORKER_MSG_HISTORY_FLUSHED, 0, 0, 0);
+    }
+}
+
+static void init(void) {
+    activity_init(&s_state);
+
+    store_load(&s_store, &s_state);
+    stats_load(&s_state.stats);
+    history_load(&s_history);
+    step_engine_init(&s_detector);
+#if DETECTOR_FLOAT_REFERENCE
+    detector_benchmark();
+#endif
+
+    app_worker_message_subscribe(message_handler);
+    sampling_init(&s_sampling);
+    // The system's step counter where there is one, the own pipeline everywhere else
+    s_health = health_start(count_steps, s_state.saved.totalSteps, s_state.saved.dayNumber);
+    if(!s_health){
+        start_stream(s_sampling.batchSize);
+    }
+    tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+    alerts_init(&s_alerts);
+    workout_init(&s_workout);
+    sleep_init(&s_sleep);
+    schedule_alert();
+}
+
+static void deinit(void) {
+    if (DEBUG) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "worker deinit() called");
+    }
+
+    store_save(&s_store, &s_state);
+    history_flush(&s_history);
+    profile_dump();
+
+    if(s_health){
+        health_stop();
+    }else if(s_suspended){
+        accel_tap_service_unsubscribe();
+    }else{
+        accel_data_service_unsubscribe();
+    }
+    tick_timer_service_unsubscribe();
+    app_worker_message_unsubscribe();
+    if(s_alert_timer){
+        app_timer_cancel(s_alert_timer);
+    }
+}
+
+int main(void) {
+    init();
+    worker_event_loop();
+    deinit();
+    return 0;
+}